@@ -5,8 +5,23 @@
 
 #include <hpx/hpx.hpp>
 #include <hpx/runtime/components/component_factory_base.hpp>
+#include <hpx/runtime/startup_function.hpp>
+
+#include "performance_counters.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 // Add factory registration functionality
 HPX_REGISTER_COMPONENT_MODULE();    // create entry point for component factory
 
+///////////////////////////////////////////////////////////////////////////////
+// Install the performance counter types of this module during startup
+namespace hpx { namespace components { namespace amr
+{
+    bool get_startup(hpx::startup_function_type& startup_func)
+    {
+        startup_func = &install_counter_types;
+        return true;
+    }
+}}}
+
+HPX_REGISTER_STARTUP_MODULE(hpx::components::amr::get_startup);
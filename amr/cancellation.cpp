@@ -0,0 +1,204 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/lcos/future_wait.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+
+#include <boost/atomic.hpp>
+
+#include <map>
+
+#include "cancellation.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+HPX_REGISTER_PLAIN_ACTION_EX(hpx::components::amr::set_cancellation_action,
+    had_set_cancellation_action);
+HPX_REGISTER_PLAIN_ACTION_EX(hpx::components::amr::get_evolution_status_action,
+    had_get_evolution_status_action);
+HPX_REGISTER_PLAIN_ACTION_EX(hpx::components::amr::clear_evolution_action,
+    had_clear_evolution_action);
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    namespace detail
+    {
+        typedef lcos::local::mutex mutex_type;
+
+        // the cancelled evolutions on this locality, protected by mtx
+        mutex_type mtx;
+        std::map<std::size_t, evolution_status> evolutions;
+
+        // number of entries in evolutions, allows the stencils to skip the
+        // lookup as long as nothing was cancelled
+        boost::atomic<std::size_t> cancelled(0);
+
+        char const* const outcome_names[evolution_last] =
+        {
+            "completed",
+            "collapsed",
+            "dispersed"
+        };
+
+        // All stencils have to stop at the same time step and none of them
+        // may have passed it already when learning about it. The stencils
+        // progress asynchronously, but each step needs the values of the
+        // neighbors of the previous step, so a stencil is ahead of another
+        // one by at most one step of the coarse level (half a cycle of the
+        // mesh) per column between them, whatever the pipeline_depth. The
+        // stop travels with the values computed after the detection, so
+        // this bounds the lead over the detection even before the
+        // cancellation has reached all localities.
+        std::size_t stop_timestep(Par const& par, std::size_t timestep)
+        {
+            std::size_t const cycle = 2*level_timestep(par, 0);
+            std::size_t const margin = par.rowsize[0]/2 + 1;
+            return (timestep/cycle + 1 + margin)*cycle;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    char const* get_outcome_name(int outcome)
+    {
+        BOOST_ASSERT(outcome >= 0 && outcome < evolution_last);
+        return detail::outcome_names[outcome];
+    }
+
+    void evolution_status::combine(evolution_status const& rhs)
+    {
+        // a stop may be known before the detection it results from
+        if (rhs.stop_timestep_ < stop_timestep_)
+            stop_timestep_ = rhs.stop_timestep_;
+
+        if (rhs.outcome_ == evolution_completed)
+            return;
+
+        if (outcome_ == evolution_completed || rhs.timestep_ < timestep_) {
+            outcome_ = rhs.outcome_;
+            timestep_ = rhs.timestep_;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    std::size_t cancel_evolution(Par const& par, evolution_outcome outcome,
+        std::size_t timestep)
+    {
+        std::size_t const stop = detail::stop_timestep(par, timestep);
+
+        // a detection reported before already covers this one
+        {
+            detail::mutex_type::scoped_lock l(detail::mtx);
+            std::map<std::size_t, evolution_status>::const_iterator it =
+                detail::evolutions.find(par.evolution_id);
+            if (it != detail::evolutions.end() &&
+                it->second.stop_timestep_ <= stop)
+            {
+                return it->second.stop_timestep_;
+            }
+        }
+
+        std::vector<naming::id_type> localities = hpx::find_all_localities();
+        for (std::size_t i = 0; i < localities.size(); ++i)
+        {
+            hpx::apply<set_cancellation_action>(localities[i],
+                par.evolution_id, int(outcome), timestep, stop);
+        }
+        return stop;
+    }
+
+    bool evolution_cancelled(std::size_t evolution,
+        std::size_t& stop_timestep)
+    {
+        if (detail::cancelled.load() == 0)
+            return false;
+
+        detail::mutex_type::scoped_lock l(detail::mtx);
+        std::map<std::size_t, evolution_status>::const_iterator it =
+            detail::evolutions.find(evolution);
+        if (it == detail::evolutions.end())
+            return false;
+
+        if (it->second.stop_timestep_ < stop_timestep)
+            stop_timestep = it->second.stop_timestep_;
+        return true;
+    }
+
+    evolution_status get_evolution_status(std::size_t evolution)
+    {
+        detail::mutex_type::scoped_lock l(detail::mtx);
+        std::map<std::size_t, evolution_status>::const_iterator it =
+            detail::evolutions.find(evolution);
+        if (it == detail::evolutions.end())
+            return evolution_status();
+        return it->second;
+    }
+
+    void clear_evolution(std::size_t evolution)
+    {
+        detail::mutex_type::scoped_lock l(detail::mtx);
+        if (detail::evolutions.erase(evolution))
+            --detail::cancelled;
+    }
+
+    void set_cancellation(std::size_t evolution, int outcome,
+        std::size_t timestep, std::size_t stop_timestep)
+    {
+        evolution_status status;
+        status.outcome_ = outcome;
+        status.timestep_ = timestep;
+        status.stop_timestep_ = stop_timestep;
+
+        detail::mutex_type::scoped_lock l(detail::mtx);
+        std::map<std::size_t, evolution_status>::iterator it =
+            detail::evolutions.find(evolution);
+        if (it == detail::evolutions.end()) {
+            detail::evolutions.insert(std::make_pair(evolution, status));
+            ++detail::cancelled;
+        }
+        else {
+            it->second.combine(status);
+        }
+    }
+
+    void note_stop(std::size_t evolution, std::size_t stop_timestep)
+    {
+        set_cancellation(evolution, evolution_completed, 0, stop_timestep);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    evolution_status query_evolution(std::size_t evolution)
+    {
+        std::vector<naming::id_type> localities = hpx::find_all_localities();
+
+        std::vector<lcos::future<evolution_status> > lazyvals;
+        for (std::size_t i = 0; i < localities.size(); ++i)
+        {
+            lazyvals.push_back(hpx::async<get_evolution_status_action>(
+                localities[i], evolution));
+        }
+
+        std::vector<evolution_status> states;
+        hpx::lcos::wait(lazyvals, states);
+
+        evolution_status result;
+        for (std::size_t i = 0; i < states.size(); ++i)
+            result.combine(states[i]);
+        return result;
+    }
+
+    void reset_evolution(std::size_t evolution)
+    {
+        std::vector<naming::id_type> localities = hpx::find_all_localities();
+
+        std::vector<lcos::future<void> > lazyvals;
+        for (std::size_t i = 0; i < localities.size(); ++i)
+        {
+            lazyvals.push_back(hpx::async<clear_evolution_action>(
+                localities[i], evolution));
+        }
+        hpx::lcos::wait(lazyvals);
+    }
+}}}
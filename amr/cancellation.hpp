@@ -0,0 +1,140 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_CANCELLATION_OCT_18_2012_0930PM)
+#define HPX_COMPONENTS_AMR_CANCELLATION_OCT_18_2012_0930PM
+
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/runtime/naming/name.hpp>
+#include <hpx/runtime/actions/plain_action.hpp>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <vector>
+
+#include "../parameter.h"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    /// The ways an evolution can end.
+    enum evolution_outcome
+    {
+        evolution_completed = 0,    // all time steps have been computed
+        evolution_collapsed = 1,    // the field blew up (a black hole formed)
+        evolution_dispersed = 2,    // the field dispersed
+        evolution_last
+    };
+
+    /// Return the name of the given outcome.
+    HPX_COMPONENT_EXPORT char const* get_outcome_name(int outcome);
+
+    /// The state of an evolution as known on one locality (or combined over
+    /// all localities).
+    struct evolution_status
+    {
+        evolution_status()
+          : outcome_(evolution_completed), timestep_(0),
+            stop_timestep_(std::size_t(-1))
+        {}
+
+        int outcome_;                   // one of evolution_outcome
+        std::size_t timestep_;          // time step of the detection
+        std::size_t stop_timestep_;     // time step all stencils stop at
+
+        /// Keep the earlier of the two detections and of the two stops
+        void combine(evolution_status const& rhs);
+
+    private:
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & outcome_ & timestep_ & stop_timestep_;
+        }
+    };
+
+    /// The result of unigrid_mesh::init_execute: the memory blocks of the
+    /// last time step and the way the evolution ended.
+    struct evolution_result
+    {
+        std::vector<naming::id_type> result_data_;
+        evolution_status status_;
+
+    private:
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & result_data_ & status_;
+        }
+    };
+
+    /// Cancel the given evolution after detecting the outcome at the given
+    /// time step (in units of the finest level step). The cancellation is
+    /// sent to all localities, the stencils do not compute any further time
+    /// step and stop at a common time step past the one of the detection,
+    /// which is returned. A stencil detecting the outcome passes the stop
+    /// on with its value (see stencil_data::stop_timestep_).
+    HPX_COMPONENT_EXPORT std::size_t cancel_evolution(Par const& par,
+        evolution_outcome outcome, std::size_t timestep);
+
+    /// Return whether the given evolution was cancelled on this locality, if
+    /// so \a stop_timestep is lowered to the time step all stencils stop at.
+    HPX_COMPONENT_EXPORT bool evolution_cancelled(std::size_t evolution,
+        std::size_t& stop_timestep);
+
+    /// Return the state of the given evolution on this locality.
+    HPX_COMPONENT_EXPORT evolution_status get_evolution_status(
+        std::size_t evolution);
+
+    /// Forget the state of the given evolution on this locality.
+    HPX_COMPONENT_EXPORT void clear_evolution(std::size_t evolution);
+
+    /// Record the cancellation of an evolution on this locality, the first
+    /// detection wins.
+    HPX_COMPONENT_EXPORT void set_cancellation(std::size_t evolution,
+        int outcome, std::size_t timestep, std::size_t stop_timestep);
+
+    /// Record on this locality the stop of an evolution learned from the
+    /// values of a neighbor, ahead of the cancellation itself.
+    HPX_COMPONENT_EXPORT void note_stop(std::size_t evolution,
+        std::size_t stop_timestep);
+
+    /// Return the state of the given evolution combined over all localities.
+    HPX_COMPONENT_EXPORT evolution_status query_evolution(
+        std::size_t evolution);
+
+    /// Forget the state of the given evolution on all localities.
+    HPX_COMPONENT_EXPORT void reset_evolution(std::size_t evolution);
+
+    ///////////////////////////////////////////////////////////////////////////
+    typedef hpx::actions::plain_action4<
+        std::size_t, int, std::size_t, std::size_t, &set_cancellation
+    > set_cancellation_action;
+
+    typedef hpx::actions::plain_result_action1<
+        evolution_status, std::size_t, &get_evolution_status
+    > get_evolution_status_action;
+
+    typedef hpx::actions::plain_action1<
+        std::size_t, &clear_evolution
+    > clear_evolution_action;
+}}}
+
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::set_cancellation_action,
+    had_set_cancellation_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::get_evolution_status_action,
+    had_get_evolution_status_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::clear_evolution_action,
+    had_clear_evolution_action);
+
+#endif
@@ -40,31 +40,34 @@ namespace hpx { namespace components { namespace amr
         // functional component derived from this class
         lcos::future<std::size_t> eval_async(naming::id_type const& result, 
             std::vector<naming::id_type> const& gids, std::size_t row, std::size_t column,
-            Parameter const& par)
+            int kind, Parameter const& par)
         {
-            return this->base_type::eval_async(this->gid_, result, gids, row, column,par);
+            return this->base_type::eval_async(this->gid_, result, gids, row, column,
+                kind, par);
         }
 
         std::size_t eval(naming::id_type const& result, 
             std::vector<naming::id_type> const& gids, std::size_t row, std::size_t column,
-            Parameter const& par)
+            int kind, Parameter const& par)
         {
-            return this->base_type::eval(this->gid_, result, gids, row, column,par);
+            return this->base_type::eval(this->gid_, result, gids, row, column,
+                kind, par);
         }
 
         ///////////////////////////////////////////////////////////////////////
         lcos::future<naming::id_type> alloc_data_async(std::size_t item,
-            std::size_t maxitems, std::size_t row, Parameter const& par)
+            std::size_t maxitems, std::size_t row, std::size_t column,
+            Parameter const& par)
         {
             return this->base_type::alloc_data_async(this->gid_, item, 
-                maxitems, row, par);
+                maxitems, row, column, par);
         }
 
         naming::id_type alloc_data(std::size_t item, std::size_t maxitems,
-            std::size_t row, Parameter const& par)
+            std::size_t row, std::size_t column, Parameter const& par)
         {
             return this->base_type::alloc_data(this->gid_, item, maxitems, 
-                row, par);
+                row, column, par);
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -72,6 +75,12 @@ namespace hpx { namespace components { namespace amr
         {
             this->base_type::init(this->gid_, numsteps, val);
         }
+
+        ///////////////////////////////////////////////////////////////////////
+        void release_data(Parameter const& par)
+        {
+            this->base_type::release_data(this->gid_, par);
+        }
     };
 
 }}}
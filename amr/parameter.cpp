@@ -4,10 +4,13 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <hpx/hpx_fwd.hpp>
+#include <hpx/exception.hpp>
+#include <hpx/util/section.hpp>
 #include <hpx/util/portable_binary_iarchive.hpp>
 #include <hpx/util/portable_binary_oarchive.hpp>
 
 #include "../parameter.hpp"
+#include "../parameter_schema.h"
 
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/shared_ptr.hpp>
@@ -15,6 +18,12 @@
 #include <boost/serialization/export.hpp>
 #include <boost/serialization/vector.hpp>
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr
 {
@@ -25,6 +34,7 @@ namespace hpx { namespace components { namespace amr
         ar & allowedl;
         ar & loglevel;
         ar & output;
+        ar & output_every;
         ar & output_stdout;
         ar & nt0;
         ar & nx0;
@@ -42,9 +52,26 @@ namespace hpx { namespace components { namespace amr
         ar & output_level;
         ar & PP;
         ar & granularity;
+        ar & granularity_level;
+        ar & checkpoint;
+        ar & checkpoint_every;
+        ar & restart;
+        ar & placement;
+        ar & prolongation_order;
+        ar & pipeline_depth;
+        ar & dataflow;
+        ar & thread_scheduler;
+        ar & numa_domains;
+        ar & diagnostics;
+        ar & dispersal_threshold;
+        ar & evolution_id;
         ar & rowsize;
         ar & level_begin;
         ar & level_end;
+        ar & each_row;
+        ar & level_row;
+        ar & level_startx;
+        ar & locality_bounds;
     }
 
     // explicit instantiation for the correct archive types
@@ -69,4 +96,292 @@ namespace hpx { namespace components { namespace amr
     template HPX_COMPONENT_EXPORT void
     Parameter::serialize(util::portable_binary_oarchive&,
         const unsigned int version);
+
+    ///////////////////////////////////////////////////////////////////////////
+    void compute_derived_parameters(Parameter& par, int nx0)
+    {
+      // levels without an explicit granularity use the global one
+      for (int i=0;i<maxlevels;i++) {
+        if ( par->granularity_level[i] <= 0 ) par->granularity_level[i] = par->granularity;
+      }
+      int const* g = par->granularity_level;
+
+      par->nx0 = nx0/g[0];
+
+      // each level covers refine_level times the extent of the next coarser
+      // level, counted in blocks of the level's own granularity
+      par->nx[0] = par->nx0;
+      for (int i=1;i<par->allowedl+1;i++) {
+        par->nx[i] = int(par->refine_level[i-1]*par->nx[i-1]*g[i-1]/g[i]);
+      }
+
+      // this may be called more than once for the same parameter set
+      par->rowsize.clear();
+      par->level_begin.clear();
+      par->level_end.clear();
+
+      for (int j=0;j<=par->allowedl;j++) {
+        par->rowsize.push_back(par->nx[par->allowedl]);
+        for (int i=par->allowedl-1;i>=j;i--) {
+          // remove duplicates: the coarse blocks covered by the finer level
+          par->rowsize[j] += par->nx[i] - (par->nx[i+1]*g[i+1] + 2*g[i]-1)/(2*g[i]);
+        }
+      }
+
+      for (int j=0;j<=par->allowedl;j++) {
+        if ( j != par->allowedl ) par->level_begin.push_back(par->rowsize[j+1]);
+        else par->level_begin.push_back(0);
+        par->level_end.push_back(par->rowsize[j]);
+      }
+
+      // the rows of the mesh (two per coarse step for each level): row i
+      // includes all levels down to the one whose timestep divides it
+      std::size_t const num_rows = std::size_t(2) << par->allowedl;
+      par->each_row.clear();
+      par->level_row.clear();
+      for (std::size_t i=0;i<num_rows;i++) {
+        int j = par->allowedl;
+        while ( j > 0 && i % (std::size_t(1) << j) != 0 ) --j;
+        par->level_row.push_back(par->allowedl-j);
+        par->each_row.push_back(par->rowsize[par->allowedl-j]);
+      }
+
+      // Compute dx
+      had_double_type tmp = 0.0;
+      for (int j=par->allowedl;j>0;j--) {
+        tmp += (par->level_end[j]-par->level_begin[j])*g[j]/double(std::size_t(1) << j);
+      }
+
+      for (int j=par->level_begin[0];j<par->rowsize[0]-1;j++) {
+        tmp += g[0];
+      }
+
+      par->dx0 = (par->maxx0 - par->minx0)/(tmp + g[0]-1);
+      par->dt0 = par->lambda*par->dx0;
+
+      // the finer levels cover the region next to the origin, each level
+      // starts where the next finer one ends
+      par->level_startx.assign(par->allowedl+1, had_double_type(0.0));
+      for (int j=par->allowedl-1;j>=0;j--) {
+        par->level_startx[j] = par->level_startx[j+1] +
+          (par->level_end[j+1]-par->level_begin[j+1])*g[j+1]*par->dx0/double(std::size_t(1) << (j+1));
+      }
+
+      // the output cadence is kept as an integer number of finest level steps
+      double output_steps = double(par->output)*level_timestep(*par.p, 0);
+      par->output_every = std::size_t(output_steps + 0.5);
+      if ( par->output_every == 0 ||
+           std::fabs(output_steps - par->output_every) > 1.e-6 ) {
+        std::cerr << " PROBLEM : output must be a multiple of the finest level timestep " << std::endl;
+        std::cerr << " output " << double(par->output) << " allowedl " << par->allowedl << std::endl;
+        HPX_THROW_EXCEPTION(bad_parameter,
+            "amr::compute_derived_parameters",
+            "output must be a multiple of the finest level timestep");
+      }
+
+      // checkpoints are taken whenever all levels are at the same time, which
+      // happens once per cycle through all rows (two coarse steps)
+      par->checkpoint_every = par->checkpoint*level_timestep(*par.p, 0);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // conversion and range check of the values of the parameter schema
+    namespace detail
+    {
+      inline int parse_int(std::string const& value)
+      {
+        return atoi(value.c_str());
+      }
+
+      inline double parse_real(std::string const& value)
+      {
+        return atof(value.c_str());
+      }
+
+      inline std::string const& parse_string(std::string const& value)
+      {
+        return value;
+      }
+
+      template <typename T>
+      bool check_range(char const* name, T const& value, double lo, double hi)
+      {
+        if ( value < lo || value > hi ) {
+          std::cerr << " PROBLEM : " << name << " must be in [" << lo << ", "
+                    << hi << "] " << std::endl;
+          std::cerr << " " << name << " " << value << std::endl;
+          return false;
+        }
+        return true;
+      }
+
+      inline bool check_int(char const* name, int value, double lo, double hi)
+      {
+        return check_range(name, value, lo, hi);
+      }
+
+      inline bool check_real(char const* name, had_double_type const& value,
+          double lo, double hi)
+      {
+        return check_range(name, double(value), lo, hi);
+      }
+
+      inline bool check_string(char const*, std::string const&, double, double)
+      {
+        return true;
+      }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void set_default_parameters(Parameter& par, int& nx0, std::size_t numsteps)
+    {
+#define HAD_AMR_SET_DEFAULT(name, kind, def, lo, hi, help)                    \
+      par->name = def;                                                        \
+      /**/
+#define HAD_AMR_SET_LEVEL_DEFAULT(name, kind, def, lo, hi, help)              \
+      for (int i=0;i<maxlevels;i++) par->name[i] = def;                       \
+      /**/
+
+      HAD_AMR_PARAMETERS(HAD_AMR_SET_DEFAULT)
+      HAD_AMR_LEVEL_PARAMETERS(HAD_AMR_SET_LEVEL_DEFAULT)
+
+#undef HAD_AMR_SET_LEVEL_DEFAULT
+#undef HAD_AMR_SET_DEFAULT
+
+      nx0              = 33;
+      par->nt0         = numsteps;
+      par->minx0       = 0.0;   // we are in spherical symmetry
+      par->evolution_id = 0;
+    }
+
+    bool set_parameter(Parameter& par, int& nx0, std::string const& key,
+        std::string const& value)
+    {
+      if ( key == "nx0" ) {
+        nx0 = detail::parse_int(value);
+        return true;
+      }
+
+#define HAD_AMR_SET_PARAMETER(name, kind, def, lo, hi, help)                  \
+      if ( key == #name ) {                                                   \
+        par->name = detail::parse_##kind(value);                              \
+        return true;                                                          \
+      }                                                                       \
+      /**/
+#define HAD_AMR_SET_LEVEL_PARAMETER(name, kind, def, lo, hi, help)            \
+      if ( sscanf(key.c_str(), #name "_%d%c", &level, &tail) == 1 &&          \
+           level >= 0 && level < maxlevels ) {                                \
+        par->name[level] = detail::parse_##kind(value);                       \
+        return true;                                                          \
+      }                                                                       \
+      /**/
+
+      int level = 0;
+      char tail = 0;
+
+      HAD_AMR_PARAMETERS(HAD_AMR_SET_PARAMETER)
+      HAD_AMR_LEVEL_PARAMETERS(HAD_AMR_SET_LEVEL_PARAMETER)
+
+#undef HAD_AMR_SET_LEVEL_PARAMETER
+#undef HAD_AMR_SET_PARAMETER
+
+      return false;
+    }
+
+    void read_parameters(util::section& sec, Parameter& par, int& nx0)
+    {
+      if ( sec.has_entry("nx0") ) {
+        set_parameter(par, nx0, "nx0", sec.get_entry("nx0"));
+      }
+
+#define HAD_AMR_READ_PARAMETER(name, kind, def, lo, hi, help)                 \
+      if ( sec.has_entry(#name) ) {                                           \
+        set_parameter(par, nx0, #name, sec.get_entry(#name));                 \
+      }                                                                       \
+      /**/
+#define HAD_AMR_READ_LEVEL_PARAMETER(name, kind, def, lo, hi, help)           \
+      for (int i=0;i<=par->allowedl;i++) {                                    \
+        char tmpname[80];                                                     \
+        sprintf(tmpname, #name "_%d", i);                                     \
+        if ( sec.has_entry(tmpname) ) {                                       \
+          set_parameter(par, nx0, tmpname, sec.get_entry(tmpname));           \
+        }                                                                     \
+      }                                                                       \
+      /**/
+
+      HAD_AMR_PARAMETERS(HAD_AMR_READ_PARAMETER)
+      HAD_AMR_LEVEL_PARAMETERS(HAD_AMR_READ_LEVEL_PARAMETER)
+
+#undef HAD_AMR_READ_LEVEL_PARAMETER
+#undef HAD_AMR_READ_PARAMETER
+    }
+
+    bool check_parameters(Parameter const& par, int nx0)
+    {
+      bool ok = true;
+
+#define HAD_AMR_CHECK_PARAMETER(name, kind, def, lo, hi, help)                \
+      ok = detail::check_##kind(#name, par->name, lo, hi) && ok;              \
+      /**/
+#define HAD_AMR_CHECK_LEVEL_PARAMETER(name, kind, def, lo, hi, help)          \
+      for (int i=0;i<=par->allowedl;i++) {                                    \
+        char tmpname[80];                                                     \
+        sprintf(tmpname, #name "_%d", i);                                     \
+        ok = detail::check_##kind(tmpname, par->name[i], lo, hi) && ok;       \
+      }                                                                       \
+      /**/
+
+      HAD_AMR_PARAMETERS(HAD_AMR_CHECK_PARAMETER)
+      // the per level checks depend on allowedl
+      if ( par->allowedl < 0 || par->allowedl >= maxlevels ) return false;
+      HAD_AMR_LEVEL_PARAMETERS(HAD_AMR_CHECK_LEVEL_PARAMETER)
+
+#undef HAD_AMR_CHECK_LEVEL_PARAMETER
+#undef HAD_AMR_CHECK_PARAMETER
+
+      // the refined levels have to leave some blocks of the coarser level
+      for (int i=0;i<par->allowedl;i++) {
+        if ( !(par->refine_level[i] > 0.0 && par->refine_level[i] < 2.0) ) {
+          std::cerr << " PROBLEM : refine_level_" << i << " must be in (0, 2) " << std::endl;
+          std::cerr << " refine_level_" << i << " " << par->refine_level[i] << std::endl;
+          ok = false;
+        }
+      }
+
+      int const g0 = par->granularity_level[0] > 0 ?
+          par->granularity_level[0] : par->granularity;
+      if ( nx0 <= 0 || nx0%g0 != 0 ) {
+        std::cerr << " PROBLEM : nx0 must be divisible by the granularity " << std::endl;
+        std::cerr << " nx0 " << nx0 << " granularity " << g0 << std::endl;
+        ok = false;
+      }
+
+      if ( par->prolongation_order % 2 != 0 ) {
+        std::cerr << " PROBLEM : prolongation_order must be 2, 4 or 6 " << std::endl;
+        std::cerr << " prolongation_order " << par->prolongation_order << std::endl;
+        ok = false;
+      }
+
+      if ( par->checkpoint % 2 != 0 ) {
+        std::cerr << " PROBLEM : checkpoint must be a non-negative multiple of 2 " << std::endl;
+        std::cerr << " checkpoint " << par->checkpoint << std::endl;
+        ok = false;
+      }
+
+      double output_steps = double(par->output)*level_timestep(*par.p, 0);
+      if ( output_steps < 0.5 ||
+           std::fabs(output_steps - std::floor(output_steps + 0.5)) > 1.e-6 ) {
+        std::cerr << " PROBLEM : output must be a multiple of the finest level timestep " << std::endl;
+        std::cerr << " output " << double(par->output) << " allowedl " << par->allowedl << std::endl;
+        ok = false;
+      }
+
+      // the dispersal is detected from the global maximum of |chi|
+      if ( par->dispersal_threshold > 0.0 && par->diagnostics == 0 ) {
+        std::cerr << " PROBLEM : dispersal_threshold needs diagnostics = 1 " << std::endl;
+        std::cerr << " dispersal_threshold " << par->dispersal_threshold << std::endl;
+        ok = false;
+      }
+      return ok;
+    }
 }}}
@@ -0,0 +1,179 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/include/performance_counters.hpp>
+
+#include <boost/atomic.hpp>
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+
+#include "performance_counters.hpp"
+#include "../parameter.h"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    namespace detail
+    {
+        // accumulated time (microseconds) per phase
+        boost::atomic<boost::int64_t> phase_times[phase_last];
+
+        char const* const phase_names[phase_last] =
+        {
+            "create_components",
+            "prep_ports",
+            "init_stencils",
+            "get_output_ports",
+            "connect_input_ports",
+            "start_row",
+            "prepare_initial_data",
+            "execute",
+            "free_components"
+        };
+
+        char const* const phase_help[phase_last] =
+        {
+            "returns the time [us] spent creating the stencil and functional "
+                "components",
+            "returns the time [us] spent computing the data-flow structure",
+            "returns the time [us] spent initializing the stencil values",
+            "returns the time [us] spent retrieving the output ports",
+            "returns the time [us] spent connecting the input ports",
+            "returns the time [us] spent starting all rows but the first",
+            "returns the time [us] spent generating the initial data",
+            "returns the time [us] spent computing the evolution",
+            "returns the time [us] spent freeing all components"
+        };
+
+        // accumulated statistics per refinement level
+        boost::atomic<boost::int64_t> stencil_statistics[maxlevels][stencil_last];
+
+        char const* const stencil_statistic_names[stencil_last] =
+        {
+            "eval_time",
+            "input_wait",
+            "output_wait",
+            "steps"
+        };
+
+        char const* const stencil_statistic_help[stencil_last] =
+        {
+            "returns the time [us] spent in the eval action by all stencils "
+                "of this refinement level",
+            "returns the time [us] the stencils of this refinement level "
+                "waited for their input values",
+            "returns the time [us] the stencils of this refinement level "
+                "waited for their output values to be consumed",
+            "returns the number of steps completed by the stencils of this "
+                "refinement level"
+        };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    char const* get_phase_name(init_phase phase)
+    {
+        BOOST_ASSERT(phase >= 0 && phase < phase_last);
+        return detail::phase_names[phase];
+    }
+
+    void add_phase_time(init_phase phase, boost::int64_t usecs)
+    {
+        BOOST_ASSERT(phase >= 0 && phase < phase_last);
+        detail::phase_times[phase] += usecs;
+    }
+
+    boost::int64_t get_phase_time(init_phase phase)
+    {
+        BOOST_ASSERT(phase >= 0 && phase < phase_last);
+        return detail::phase_times[phase].load();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    char const* get_stencil_statistic_name(stencil_statistic stat)
+    {
+        BOOST_ASSERT(stat >= 0 && stat < stencil_last);
+        return detail::stencil_statistic_names[stat];
+    }
+
+    void add_stencil_statistic(int level, stencil_statistic stat,
+        boost::int64_t value)
+    {
+        BOOST_ASSERT(level >= 0 && level < maxlevels);
+        BOOST_ASSERT(stat >= 0 && stat < stencil_last);
+        detail::stencil_statistics[level][stat] += value;
+    }
+
+    boost::int64_t get_stencil_statistic(int level, stencil_statistic stat)
+    {
+        BOOST_ASSERT(level >= 0 && level < maxlevels);
+        BOOST_ASSERT(stat >= 0 && stat < stencil_last);
+        return detail::stencil_statistics[level][stat].load();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void reset_performance_data()
+    {
+        for (int i = 0; i < phase_last; ++i)
+            detail::phase_times[i] = 0;
+
+        for (int level = 0; level < maxlevels; ++level)
+        {
+            for (int i = 0; i < stencil_last; ++i)
+                detail::stencil_statistics[level][i] = 0;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void install_counter_types()
+    {
+        for (int i = 0; i < phase_last; ++i)
+        {
+            std::string name("/had_amr/init_execute/");
+            name += detail::phase_names[i];
+            performance_counters::install_counter_type(name,
+                boost::bind(&get_phase_time, init_phase(i)),
+                detail::phase_help[i]);
+        }
+
+        for (int level = 0; level < maxlevels; ++level)
+        {
+            for (int i = 0; i < stencil_last; ++i)
+            {
+                std::string name("/had_amr/stencil/level_");
+                name += boost::lexical_cast<std::string>(level);
+                name += "/";
+                name += detail::stencil_statistic_names[i];
+                performance_counters::install_counter_type(name,
+                    boost::bind(&get_stencil_statistic, level,
+                        stencil_statistic(i)),
+                    detail::stencil_statistic_help[i]);
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void print_phase_timings(std::ostream& os)
+    {
+        boost::int64_t total = 0;
+        for (int i = 0; i < phase_last; ++i)
+            total += detail::phase_times[i].load();
+
+        os << "init_execute phase timings:\n"
+           << boost::format("  %-22s %14s %8s\n") % "phase" % "time [s]" % "[%]";
+        for (int i = 0; i < phase_last; ++i)
+        {
+            boost::int64_t usecs = detail::phase_times[i].load();
+            os << boost::format("  %-22s %14.6f %8.2f\n")
+                  % detail::phase_names[i] % (usecs * 1e-6)
+                  % (total ? 100.0 * usecs / total : 0.0);
+        }
+        os << boost::format("  %-22s %14.6f %8.2f\n")
+              % "total" % (total * 1e-6) % (total ? 100.0 : 0.0);
+    }
+}}}
@@ -0,0 +1,117 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_PERFORMANCE_COUNTERS_OCT_18_2012_1012AM)
+#define HPX_COMPONENTS_AMR_PERFORMANCE_COUNTERS_OCT_18_2012_1012AM
+
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <boost/cstdint.hpp>
+
+#include <iosfwd>
+
+#include <hpx/config/warnings_prefix.hpp>
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    /// The phases of unigrid_mesh::init_execute which are timed separately.
+    enum init_phase
+    {
+        phase_create_components = 0,
+        phase_prep_ports,
+        phase_init_stencils,
+        phase_get_output_ports,
+        phase_connect_input_ports,
+        phase_start_row,
+        phase_prepare_initial_data,
+        phase_execute,
+        phase_free_components,
+        phase_last
+    };
+
+    /// Return the name of the given phase as used for the performance
+    /// counters (/had_amr/init_execute/<name>) and the summary table.
+    HPX_COMPONENT_EXPORT char const* get_phase_name(init_phase phase);
+
+    /// Accumulate the time (in microseconds) spent in the given phase.
+    HPX_COMPONENT_EXPORT void add_phase_time(init_phase phase,
+        boost::int64_t usecs);
+
+    /// Return the accumulated time (in microseconds) spent in the given phase
+    /// on this locality.
+    HPX_COMPONENT_EXPORT boost::int64_t get_phase_time(init_phase phase);
+
+    /// The statistics collected per refinement level by the driver threads of
+    /// the dynamic_stencil_value instances on this locality.
+    enum stencil_statistic
+    {
+        stencil_eval_time = 0,      // time [us] spent in the eval action
+        stencil_input_wait,         // time [us] spent waiting for the inputs
+        stencil_output_wait,        // time [us] spent waiting for the readers
+        stencil_steps,              // number of completed steps
+        stencil_last
+    };
+
+    /// Return the name of the given statistic as used for the performance
+    /// counters (/had_amr/stencil/level_<N>/<name>).
+    HPX_COMPONENT_EXPORT char const* get_stencil_statistic_name(
+        stencil_statistic stat);
+
+    /// Accumulate the given value for the statistic of a refinement level.
+    HPX_COMPONENT_EXPORT void add_stencil_statistic(int level,
+        stencil_statistic stat, boost::int64_t value);
+
+    /// Return the accumulated value of a statistic for a refinement level on
+    /// this locality.
+    HPX_COMPONENT_EXPORT boost::int64_t get_stencil_statistic(int level,
+        stencil_statistic stat);
+
+    /// Reset all phase timings and stencil statistics collected on this
+    /// locality so far (used to discard calibration runs).
+    HPX_COMPONENT_EXPORT void reset_performance_data();
+
+    /// Install the performance counter types for all phases and all stencil
+    /// statistics, this is invoked during startup of the runtime system.
+    HPX_COMPONENT_EXPORT void install_counter_types();
+
+    /// Print a table showing how the wall time of init_execute on this
+    /// locality was split between its phases.
+    HPX_COMPONENT_EXPORT void print_phase_timings(std::ostream& os);
+
+    ///////////////////////////////////////////////////////////////////////////
+    /// Measure the time spent until the end of the current scope (or until
+    /// stop is called) and attribute it to the given phase.
+    class phase_timer
+    {
+    public:
+        explicit phase_timer(init_phase phase)
+          : phase_(phase), stopped_(false)
+        {}
+
+        ~phase_timer()
+        {
+            stop();
+        }
+
+        void stop()
+        {
+            if (!stopped_) {
+                stopped_ = true;
+                add_phase_time(phase_, boost::int64_t(t_.elapsed() * 1e6));
+            }
+        }
+
+    private:
+        init_phase phase_;
+        bool stopped_;
+        hpx::util::high_resolution_timer t_;
+    };
+}}}
+
+#include <hpx/config/warnings_suffix.hpp>
+
+#endif
@@ -75,6 +75,13 @@ namespace hpx { namespace components { namespace amr { namespace server
         /// Main thread function looping through all timesteps
         threads::thread_state main();
 
+        /// Thread function computing a single time step once its inputs
+        /// have arrived (par->dataflow == 1)
+        threads::thread_state update();
+
+        /// Run update() in a new thread
+        void schedule_update();
+
         /// This is the main entry point of this component. Calling this
         /// function (by applying the call_action) will trigger the repeated
         /// execution of the whole time step evolution functionality.
@@ -138,6 +145,13 @@ namespace hpx { namespace components { namespace amr { namespace server
         > start_action;
 
     private:
+        struct dataflow_state;
+
+        // the priority and the worker thread of the threads computing the
+        // time steps of this stencil
+        threads::thread_priority get_priority() const;
+        std::size_t get_os_thread() const;
+
         bool is_called_;                              // is one of the 'main' stencils
         threads::thread_id_type driver_thread_;
 
@@ -148,11 +162,24 @@ namespace hpx { namespace components { namespace amr { namespace server
         std::vector<boost::shared_ptr<in_adaptor_type> > in_;   // adaptors used to gather input
         std::vector<naming::id_type> out_;                      // adaptors used to provide result
 
-        naming::id_type value_gids_[2];               // reference to previous values
+        // par->dataflow == 1 only: the in-ports the producers deliver their
+        // values to, the out-ports of the producers and the bookkeeping
+        // shared with the ports
+        std::vector<naming::id_type> inports_;
+        std::vector<naming::id_type> producers_;
+        boost::shared_ptr<dataflow_state> dataflow_;
+
+        // value_gids_[0] references the value being computed, the others
+        // form a ring of the par->pipeline_depth-1 values published last
+        std::vector<naming::id_type> value_gids_;
+        std::size_t published_;                       // number of values published
+        std::vector<std::size_t> read_;               // number of values read by each out-port
         naming::id_type functional_gid_;              // reference to functional code
 
         int row_;             // position of this stencil in whole graph
         int column_;
+        int level_;           // refinement level of this stencil
+        int kind_;            // kind of this stencil (see get_stencil_kind())
         std::size_t instencilsize_;
         std::size_t outstencilsize_;
         Parameter par_;
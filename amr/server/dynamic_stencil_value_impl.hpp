@@ -12,10 +12,15 @@
 
 #include <algorithm>
 
+#include <hpx/runtime/applier/apply.hpp>
+#include <hpx/lcos/async.hpp>
+#include <hpx/lcos/future_wait.hpp>
 #include <hpx/util/unlock_lock.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
 
 #include "dynamic_stencil_value.hpp"
 #include "../functional_component.hpp"
+#include "../performance_counters.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr { namespace server
@@ -26,26 +31,38 @@ namespace hpx { namespace components { namespace amr { namespace server
         template <typename Adaptor>
         static std::size_t
         call(naming::id_type const& gid, naming::id_type const& value_gid,
-            int row, int column, Adaptor &in, Parameter const& par)
+            int row, int column, int level, int kind, Adaptor &in,
+            Parameter const& par)
         {
+            util::high_resolution_timer t;
+
             std::vector<naming::id_type> input_gids(in.size());
             for (std::size_t i = 0; i < in.size(); ++i)
                 input_gids[i] = in[i]->get_future().get();
 
-            return components::amr::stubs::functional_component::eval(
-                gid, value_gid, input_gids, row, column, par);
+            double input_wait = t.elapsed();
+            add_stencil_statistic(level, stencil_input_wait,
+                boost::int64_t(input_wait * 1e6));
+
+            std::size_t result =
+                components::amr::stubs::functional_component::eval(
+                    gid, value_gid, input_gids, row, column, kind, par);
+
+            add_stencil_statistic(level, stencil_eval_time,
+                boost::int64_t((t.elapsed() - input_wait) * 1e6));
+            return result;
         }
     };
 
     ///////////////////////////////////////////////////////////////////////////
     template <typename Lock>
     inline naming::id_type
-    alloc_helper(Lock& l, naming::id_type const& gid, int row,
+    alloc_helper(Lock& l, naming::id_type const& gid, int row, int column,
         Parameter const& par)
     {
         util::unlock_the_lock<Lock> ul(l);
         return components::amr::stubs::functional_component::alloc_data(
-            gid, -1, -1, row, par);
+            gid, -1, -1, row, column, par);
     }
 
     inline void
@@ -54,14 +71,132 @@ namespace hpx { namespace components { namespace amr { namespace server
         components::stubs::memory_block::free_sync(gid);
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    // The bookkeeping of a stencil computing its time steps as continuations
+    // of its inputs (par->dataflow == 1): the producers deliver each value
+    // they publish to the in-ports of their consumers, the consumers release
+    // the values they are done with through the out-ports of the producers.
+    // The ports refer to this state only, which outlives the stencil, as
+    // values and releases may still arrive after its last time step.
+    struct dynamic_stencil_value::dataflow_state
+    {
+        typedef lcos::local::mutex mutex_type;
+
+        dataflow_state(dynamic_stencil_value* self, std::size_t depth,
+                std::size_t instencilsize, std::size_t outstencilsize)
+          : self_(self), depth_(depth), started_(false), running_(false),
+            finished_(false), updates_(0), published_(0),
+            inputs_(instencilsize,
+                std::vector<naming::id_type>(depth, naming::invalid_id)),
+            consumers_(outstencilsize, naming::invalid_id),
+            released_(outstencilsize, 0),
+            mtx_("dynamic_stencil_value::dataflow_state")
+        {}
+
+        // Whether the next time step can be computed: all of its inputs
+        // have arrived and all consumers have released the oldest value in
+        // the ring, as its memory_block is going to be overwritten. The time
+        // step is marked as running if so, it has to be scheduled by the
+        // caller after releasing the lock.
+        bool ready(mutex_type::scoped_lock&)
+        {
+            if (!started_ || running_ || finished_)
+                return false;
+
+            std::size_t slot = updates_ % depth_;
+            for (std::size_t i = 0; i < inputs_.size(); ++i) {
+                if (naming::invalid_id == inputs_[i][slot])
+                    return false;
+            }
+            for (std::size_t i = 0; i < released_.size(); ++i) {
+                if (released_[i] + depth_ < published_ + 1)
+                    return false;
+            }
+
+            running_ = true;
+            return true;
+        }
+
+        void start()
+        {
+            bool is_ready = false;
+            {
+                mutex_type::scoped_lock l(mtx_);
+                started_ = true;
+                is_ready = ready(l);
+            }
+            if (is_ready)
+                self_->schedule_update();
+        }
+
+        // the events received by the in-port 'port'
+        void input_event(std::size_t port, int event, std::size_t count,
+            naming::id_type const& gid)
+        {
+            BOOST_ASSERT(port_value == event);
+
+            bool is_ready = false;
+            {
+                mutex_type::scoped_lock l(mtx_);
+                if (finished_)
+                    return;       // not needed anymore
+
+                // the producers can't get more than depth values ahead (the
+                // inputs of the running time step have been taken already)
+                BOOST_ASSERT(count >= updates_ && count <= updates_ + depth_);
+                BOOST_ASSERT(naming::invalid_id == inputs_[port][count % depth_]);
+                inputs_[port][count % depth_] = gid;
+                is_ready = ready(l);
+            }
+            if (is_ready)
+                self_->schedule_update();
+        }
+
+        // the events received by the out-port 'port'
+        void output_event(std::size_t port, int event, std::size_t count,
+            naming::id_type const& gid)
+        {
+            bool is_ready = false;
+            {
+                mutex_type::scoped_lock l(mtx_);
+                if (port_connect == event) {
+                    consumers_[port] = gid;
+                    return;
+                }
+
+                BOOST_ASSERT(port_release == event);
+                ++released_[port];
+                is_ready = ready(l);
+            }
+            if (is_ready)
+                self_->schedule_update();
+        }
+
+        dynamic_stencil_value* self_;   // must not be used once finished_ is set
+        std::size_t depth_;
+        bool started_;                  // start() or call() has been invoked
+        bool running_;                  // a time step is being computed
+        bool finished_;                 // the last time step has been computed
+        std::size_t updates_;           // number of time steps computed
+        std::size_t published_;         // number of values published
+
+        // the values delivered to each in-port, indexed by their count
+        // modulo depth_
+        std::vector<std::vector<naming::id_type> > inputs_;
+        std::vector<naming::id_type> consumers_;  // in-port connected to each out-port
+        std::vector<std::size_t> released_;       // values released through each out-port
+
+        mutex_type mtx_;
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     inline dynamic_stencil_value::dynamic_stencil_value()
       : is_called_(false), driver_thread_(0), sem_result_(0),
-        functional_gid_(naming::invalid_id), row_(-1), column_(-1),
-        instencilsize_(-1), outstencilsize_(-1), mtx_("dynamic_stencil_value")
+        published_(0), functional_gid_(naming::invalid_id), row_(-1),
+        column_(-1), level_(0), kind_(stencil_interior), instencilsize_(-1),
+        outstencilsize_(-1),
+        mtx_("dynamic_stencil_value")
     {
-        std::fill(&value_gids_[0], &value_gids_[2], naming::invalid_id);
-
         // the threads driving the computation are created in
         // set_functional_component only (see below)
     }
@@ -72,8 +207,19 @@ namespace hpx { namespace components { namespace amr { namespace server
 
     inline void dynamic_stencil_value::finalize()
     {
-       if (naming::invalid_id != value_gids_[1])
-            free_helper_sync(value_gids_[1]);
+        // value_gids_[0] is freed by the driver thread
+        for (std::size_t i = 1; i < value_gids_.size(); ++i) {
+            if (naming::invalid_id != value_gids_[i])
+                free_helper_sync(value_gids_[i]);
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // the published values are stored in value_gids_[1..pipeline_depth-1] in
+    // the order they have been published
+    inline std::size_t ring_slot(std::size_t count, std::size_t depth)
+    {
+        return 1 + count % (depth - 1);
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -82,10 +228,6 @@ namespace hpx { namespace components { namespace amr { namespace server
     // result
     inline naming::id_type dynamic_stencil_value::call(naming::id_type const& initial)
     {
-        start();
-
-        is_called_ = true;
-
         // this needs to have been initialized
         if (std::size_t(-1) == instencilsize_ || std::size_t(-1) == outstencilsize_) {
             HPX_THROW_EXCEPTION(bad_parameter,
@@ -94,15 +236,50 @@ namespace hpx { namespace components { namespace amr { namespace server
             return naming::invalid_id;
         }
 
-        // sem_in_ is pre-initialized to 1, so we need to reset it
+        is_called_ = true;
+
+        if (dataflow_) {
+            // the initial value is the first one published, the time steps
+            // may be computed afterwards only
+            std::vector<naming::id_type> consumers;
+            {
+                dataflow_state::mutex_type::scoped_lock l(dataflow_->mtx_);
+                BOOST_ASSERT(dataflow_->published_ == 0);
+                value_gids_[ring_slot(0, value_gids_.size())] = initial;
+                ++dataflow_->published_;
+                consumers = dataflow_->consumers_;
+            }
+
+            for (std::size_t i = 0; i < outstencilsize_; ++i) {
+                hpx::apply<out_adaptor_type::wrapped_type::signal_action>(
+                    consumers[i], port_value, std::size_t(0), initial);
+            }
+            dataflow_->start();
+
+            // wait for final result
+            sem_result_.wait();
+
+            naming::id_type result = naming::invalid_id;
+            {
+                dataflow_state::mutex_type::scoped_lock l(dataflow_->mtx_);
+                std::swap(value_gids_[ring_slot(dataflow_->published_-1,
+                    value_gids_.size())], result);
+            }
+            return result;
+        }
+
+        start();
+
+        // the initial value occupies one of the slots of the ring
         for (std::size_t i = 0; i < outstencilsize_; ++i)
             sem_in_[i]->wait();
 
         // set new current value
         {
             mutex_type::scoped_lock l(mtx_);
-            BOOST_ASSERT(value_gids_[1] == naming::invalid_id);   // shouldn't be initialized yet
-            value_gids_[1] = initial;
+            BOOST_ASSERT(published_ == 0);    // shouldn't be initialized yet
+            value_gids_[ring_slot(published_, value_gids_.size())] = initial;
+            ++published_;
         }
 
         // signal all output threads it's safe to read value
@@ -117,7 +294,8 @@ namespace hpx { namespace components { namespace amr { namespace server
 
         {
             mutex_type::scoped_lock l(mtx_);
-            std::swap(value_gids_[1], result);
+            std::swap(value_gids_[ring_slot(published_-1, value_gids_.size())],
+                result);
         }
 
         return result;
@@ -134,7 +312,7 @@ namespace hpx { namespace components { namespace amr { namespace server
         // ask functional component to create the local data value
         {
             mutex_type::scoped_lock l(mtx_);
-            value_gids_[0] = alloc_helper(l, functional_gid_, row_, par_);
+            value_gids_[0] = alloc_helper(l, functional_gid_, row_, column_, par_);
         }
 
         // we need to store our current value gid/is_called_ on the stack,
@@ -142,6 +320,7 @@ namespace hpx { namespace components { namespace amr { namespace server
         // already
         naming::id_type value_gid_to_be_freed = value_gids_[0];
         bool is_called = is_called_;
+        int level = level_;
 
         // this is the main loop of the computation, gathering the values
         // from the previous time step, computing the result of the current
@@ -161,31 +340,39 @@ namespace hpx { namespace components { namespace amr { namespace server
             // The eval action returns an integer allowing to finish
             // computation (>0: still to go, 0: last step, <0: overdone)
             timesteps_to_go = eval_helper::call(functional_gid_,
-                value_gids_[0], row_, column_, in_, par_);
+                value_gids_[0], row_, column_, level_, kind_, in_, par_);
 
-            // Wait for all output threads to have read the current value.
-            // On the first time step the semaphore is preset to allow
-            // to immediately set the value.
+            // Wait for all output threads to have read the oldest value in
+            // the ring. The semaphores are preset to allow publishing
+            // pipeline_depth-1 values ahead of the slowest reader.
+            util::high_resolution_timer t;
             for (std::size_t i = 0; i < outstencilsize_; ++i)
                 sem_in_[i]->wait();
+            add_stencil_statistic(level_, stencil_output_wait,
+                boost::int64_t(t.elapsed() * 1e6));
 
-            // set new current value, allocate space for next current value
-            // if needed (this may happen for all time steps except the first
-            // one, where the first gets it's initial value during the
-            // call_action)
+            // set new current value, reusing the slot of the oldest value,
+            // allocate space for next current value if the slot is still
+            // empty (this happens while the ring is being filled)
             {
                 mutex_type::scoped_lock l(mtx_);
 
-                if (naming::invalid_id == value_gids_[1])
-                    value_gids_[1] = alloc_helper(l, functional_gid_, row_, par_);
+                std::size_t slot = ring_slot(published_, value_gids_.size());
+                if (naming::invalid_id == value_gids_[slot])
+                    value_gids_[slot] = alloc_helper(l, functional_gid_, row_, column_, par_);
 
-                std::swap(value_gids_[0], value_gids_[1]);
+                std::swap(value_gids_[0], value_gids_[slot]);
+                ++published_;
                 value_gid_to_be_freed = value_gids_[0];
             }
 
             // signal all output threads it's safe to read value
             for (std::size_t i = 0; i < outstencilsize_; ++i)
                 sem_out_[i]->signal();
+
+            // 'this' must not be accessed anymore after the last value has
+            // been published
+            add_stencil_statistic(level, stencil_steps, 1);
         }
 
         if (is_called)
@@ -195,17 +382,135 @@ namespace hpx { namespace components { namespace amr { namespace server
         return threads::thread_state(threads::terminated);
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    // The update thread computes a single time step of this instance, it is
+    // scheduled by the dataflow_state once the inputs have arrived, instead
+    // of having a main thread waiting for them:
+    // - calculate current result from the delivered values
+    // - release the inputs to their producers
+    // - publish the result and deliver it to the consumers
+    inline threads::thread_state dynamic_stencil_value::update()
+    {
+        std::vector<naming::id_type> input_gids(instencilsize_);
+        std::size_t count = 0;
+        std::size_t published = 0;
+        {
+            dataflow_state::mutex_type::scoped_lock l(dataflow_->mtx_);
+            count = dataflow_->updates_;
+            published = dataflow_->published_;
+
+            std::size_t slot = count % dataflow_->depth_;
+            for (std::size_t i = 0; i < instencilsize_; ++i)
+                std::swap(input_gids[i], dataflow_->inputs_[i][slot]);
+        }
+
+        // ask functional component to create the local data value
+        if (naming::invalid_id == value_gids_[0]) {
+            value_gids_[0] = components::amr::stubs::functional_component::
+                alloc_data(functional_gid_, -1, -1, row_, column_, par_);
+        }
+
+        // Compute the next value, store it in value_gids_[0]
+        util::high_resolution_timer t;
+        int timesteps_to_go = components::amr::stubs::functional_component::eval(
+            functional_gid_, value_gids_[0], input_gids, row_, column_, kind_,
+            par_);
+        add_stencil_statistic(level_, stencil_eval_time,
+            boost::int64_t(t.elapsed() * 1e6));
+
+        // the producers may overwrite the inputs now
+        for (std::size_t i = 0; i < instencilsize_; ++i) {
+            hpx::apply<out_adaptor_type::wrapped_type::signal_action>(
+                producers_[i], port_release, count, naming::invalid_id);
+        }
+
+        // set new current value, reusing the slot of the oldest value (all
+        // consumers have released it before this time step was started),
+        // allocate space for next current value if the slot is still empty
+        std::size_t slot = ring_slot(published, value_gids_.size());
+        if (naming::invalid_id == value_gids_[slot]) {
+            value_gids_[slot] = components::amr::stubs::functional_component::
+                alloc_data(functional_gid_, -1, -1, row_, column_, par_);
+        }
+        std::swap(value_gids_[0], value_gids_[slot]);
+
+        bool is_last = timesteps_to_go <= 0;
+        std::vector<naming::id_type> consumers;
+        {
+            dataflow_state::mutex_type::scoped_lock l(dataflow_->mtx_);
+            ++dataflow_->updates_;
+            ++dataflow_->published_;
+            dataflow_->finished_ = is_last;
+            consumers = dataflow_->consumers_;
+        }
+
+        for (std::size_t i = 0; i < outstencilsize_; ++i) {
+            hpx::apply<out_adaptor_type::wrapped_type::signal_action>(
+                consumers[i], port_value, published, value_gids_[slot]);
+        }
+        add_stencil_statistic(level_, stencil_steps, 1);
+
+        if (is_last) {
+            // 'this' must not be accessed anymore after the final result has
+            // been set
+            naming::id_type value_gid_to_be_freed = value_gids_[0];
+            if (is_called_)
+                sem_result_.signal();
+            free_helper_sync(value_gid_to_be_freed);
+            return threads::thread_state(threads::terminated);
+        }
+
+        // the next time step may have become ready while this one was
+        // running
+        bool is_ready = false;
+        {
+            dataflow_state::mutex_type::scoped_lock l(dataflow_->mtx_);
+            dataflow_->running_ = false;
+            is_ready = dataflow_->ready(l);
+        }
+        if (is_ready)
+            schedule_update();
+
+        return threads::thread_state(threads::terminated);
+    }
+
+    inline void dynamic_stencil_value::schedule_update()
+    {
+        applier::register_thread(
+            boost::bind(&dynamic_stencil_value::update, this),
+            "dynamic_stencil_value::update", threads::pending, true,
+            get_priority(), get_os_thread());
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // the priorities take effect with the priority_local scheduler only
+    inline threads::thread_priority dynamic_stencil_value::get_priority() const
+    {
+        if (par_->thread_scheduler == 1 && is_critical_column(*par_.p, column_))
+            return threads::thread_priority_critical;
+        return threads::thread_priority_normal;
+    }
+
+    // the time steps are computed in the NUMA domain the values are
+    // allocated in
+    inline std::size_t dynamic_stencil_value::get_os_thread() const
+    {
+        return numa_os_thread(*par_.p, column_, hpx::get_os_thread_count());
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     /// The function get will be called by the out-ports whenever
     /// the current value has been requested.
     inline naming::id_type dynamic_stencil_value::get_value(int i)
     {
-        sem_out_[i]->wait();     // wait for the current value to be valid
+        sem_out_[i]->wait();     // wait for the next value to be valid
 
         naming::id_type result = naming::invalid_id;
         {
+            // acquire the oldest value not read by this port yet
             mutex_type::scoped_lock l(mtx_);
-            result = value_gids_[1];  // acquire the current value
+            result = value_gids_[ring_slot(read_[i], value_gids_.size())];
+            ++read_[i];
         }
 
         sem_in_[i]->signal();         // signal to have read the value
@@ -256,6 +561,19 @@ namespace hpx { namespace components { namespace amr { namespace server
         for (std::size_t i = 0; i < instencilsize_; ++i)
             in_[i]->connect(gids[i]);
 
+        // subscribe the in-ports to the out-ports of the producers, this has
+        // to be done before any value is published
+        if (dataflow_) {
+            std::vector<lcos::future<void> > lazyvals;
+            producers_.assign(gids.begin(), gids.begin() + instencilsize_);
+            for (std::size_t i = 0; i < instencilsize_; ++i) {
+                lazyvals.push_back(
+                    hpx::async<out_adaptor_type::wrapped_type::signal_action>(
+                        gids[i], port_connect, i, inports_[i]));
+            }
+            hpx::lcos::wait(lazyvals);
+        }
+
         return util::unused;
     }
 
@@ -273,23 +591,61 @@ namespace hpx { namespace components { namespace amr { namespace server
         outstencilsize_ = outstencilsize;
         par_ = par;
 
+        // the refinement level is used to aggregate the performance data
+        level_ = level_of_column(*par.p, column);
+
+        // the number of inputs of this stencil is fixed, so is its kind
+        kind_ = get_stencil_kind(*par.p, column, instencilsize);
+
+        // one slot for the value being computed, the others for the values
+        // published last
+        value_gids_.assign(par->pipeline_depth, naming::invalid_id);
+        read_.assign(outstencilsize, 0);
+
         sem_in_.resize(outstencilsize);
         sem_out_.resize(outstencilsize);
         in_.resize(instencilsize);
         out_.resize(outstencilsize);
 
-        // create adaptors
+        if (par->dataflow) {
+            dataflow_.reset(new dataflow_state(this, par->pipeline_depth,
+                instencilsize, outstencilsize));
+        }
+
+        // create adaptors, the events of the ports are handled by the
+        // dataflow_state only
+        typedef out_adaptor_type::wrapped_type::event_function_type
+            event_function_type;
+
+        inports_.resize(dataflow_ ? instencilsize : 0);
         for (std::size_t i = 0; i < instencilsize_; ++i)
         {
             in_[i].reset(new in_adaptor_type());
+            if (dataflow_) {
+                inports_[i] = naming::id_type(
+                    components::server::create_one<out_adaptor_type>(
+                        out_adaptor_type::wrapped_type::callback_function_type(),
+                        event_function_type(boost::bind(
+                            &dataflow_state::input_event, dataflow_, i,
+                            _1, _2, _3))),
+                        naming::id_type::managed);
+            }
         }
         for (std::size_t i = 0; i < outstencilsize_; ++i)
         {
-            sem_in_[i].reset(new lcos::local::counting_semaphore(1));
+            event_function_type event;
+            if (dataflow_) {
+                event = boost::bind(&dataflow_state::output_event, dataflow_, i,
+                    _1, _2, _3);
+            }
+
+            sem_in_[i].reset(new lcos::local::counting_semaphore(
+                par->pipeline_depth - 1));
             sem_out_[i].reset(new lcos::local::counting_semaphore());
             out_[i] = naming::id_type(
                 components::server::create_one<out_adaptor_type>(
-                    boost::bind(&dynamic_stencil_value::get_value, this, i)),
+                    boost::bind(&dynamic_stencil_value::get_value, this, i),
+                    event),
                     naming::id_type::managed);
         }
         return util::unused;
@@ -299,6 +655,12 @@ namespace hpx { namespace components { namespace amr { namespace server
     inline util::unused_type
     dynamic_stencil_value::start()
     {
+        // the time steps are scheduled as soon as their inputs have arrived
+        if (dataflow_) {
+            dataflow_->start();
+            return util::unused;
+        }
+
         // if all inputs have been bound already we need to start the driver
         // thread
         if (0 == driver_thread_) {
@@ -311,7 +673,8 @@ namespace hpx { namespace components { namespace amr { namespace server
                 // functional element and sets the value for the next time step
                 driver_thread_ = applier::register_thread(
                     boost::bind(&dynamic_stencil_value::main, this),
-                    "dynamic_stencil_value::main");
+                    "dynamic_stencil_value::main", threads::pending, true,
+                    get_priority(), get_os_thread());
             }
         }
         return util::unused;
@@ -49,7 +49,7 @@ namespace hpx { namespace components { namespace amr { namespace server
         // functional component derived from this class
         virtual std::size_t eval(naming::id_type const&,
             std::vector<naming::id_type> const&, std::size_t, std::size_t,
-            Parameter const&)
+            int, Parameter const&)
         {
             // This shouldn't ever be called. If you're seeing this assertion
             // you probably forgot to overload this function in your stencil
@@ -59,7 +59,8 @@ namespace hpx { namespace components { namespace amr { namespace server
         }
 
         virtual naming::id_type alloc_data(std::size_t item,
-            std::size_t maxitems, std::size_t row, Parameter const&)
+            std::size_t maxitems, std::size_t row, std::size_t column,
+            Parameter const&)
         {
             // This shouldn't ever be called. If you're seeing this assertion
             // you probably forgot to overload this function in your stencil
@@ -76,6 +77,12 @@ namespace hpx { namespace components { namespace amr { namespace server
             BOOST_ASSERT(false);
         }
 
+        // Called once on each locality after all initial data has been
+        // created, anything kept for creating it may be released
+        virtual void release_data(Parameter const&)
+        {
+        }
+
         ///////////////////////////////////////////////////////////////////////
         // parcel action code: the action to be performed on the destination
         // object (the accumulator)
@@ -83,24 +90,27 @@ namespace hpx { namespace components { namespace amr { namespace server
         {
             functional_component_alloc_data = 0,
             functional_component_eval = 1,
-            functional_component_init = 2
+            functional_component_init = 2,
+            functional_component_release_data = 3
         };
 
         /// This is the main entry point of this component. Calling this
         /// function (by applying the eval_action) will compute the next
         /// time step value based on the result values of the previous time
-        /// steps.
+        /// steps. The \a kind of the stencil (see get_stencil_kind()) is
+        /// fixed for each stencil, it is determined once by the caller.
         std::size_t eval_nonvirt(naming::id_type const& result,
             std::vector<naming::id_type> const& gids, std::size_t row,
-            std::size_t column, Parameter const& par)
+            std::size_t column, int kind, Parameter const& par)
         {
-            return eval(result, gids, row, column,par);
+            return eval(result, gids, row, column, kind, par);
         }
 
         naming::id_type alloc_data_nonvirt(std::size_t item,
-            std::size_t maxitems, std::size_t row, Parameter const& par)
+            std::size_t maxitems, std::size_t row, std::size_t column,
+            Parameter const& par)
         {
-            return alloc_data(item, maxitems, row, par);
+            return alloc_data(item, maxitems, row, column, par);
         }
 
         util::unused_type
@@ -110,22 +120,29 @@ namespace hpx { namespace components { namespace amr { namespace server
             return util::unused;
         }
 
+        util::unused_type
+        release_data_nonvirt(Parameter const& par)
+        {
+            release_data(par);
+            return util::unused;
+        }
+
         ///////////////////////////////////////////////////////////////////////
         // Each of the exposed functions needs to be encapsulated into an action
         // type, allowing to generate all required boilerplate code for threads,
         // serialization, etc.
-        typedef hpx::actions::result_action4<
+        typedef hpx::actions::result_action5<
             functional_component, naming::id_type,
             functional_component_alloc_data,
-            std::size_t, std::size_t, std::size_t,
+            std::size_t, std::size_t, std::size_t, std::size_t,
             Parameter const&,
             &functional_component::alloc_data_nonvirt
         > alloc_data_action;
 
-        typedef hpx::actions::result_action5<
+        typedef hpx::actions::result_action6<
             functional_component, std::size_t, functional_component_eval,
             naming::id_type const&, std::vector<naming::id_type> const&,
-            std::size_t, std::size_t,Parameter const&,
+            std::size_t, std::size_t, int, Parameter const&,
             &functional_component::eval_nonvirt
         > eval_action;
 
@@ -134,6 +151,12 @@ namespace hpx { namespace components { namespace amr { namespace server
             std::size_t, naming::id_type const&,
             &functional_component::init_nonvirt
         > init_action;
+
+        typedef hpx::actions::result_action1<
+            functional_component, util::unused_type,
+            functional_component_release_data, Parameter const&,
+            &functional_component::release_data_nonvirt
+        > release_data_action;
     };
 }}}}
 
@@ -146,5 +169,8 @@ HPX_REGISTER_ACTION_DECLARATION_EX(
 HPX_REGISTER_ACTION_DECLARATION_EX(
     hpx::components::amr::server::functional_component::init_action,
     had_functional_component_init_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::server::functional_component::release_data_action,
+    had_functional_component_release_data_action);
 
 #endif
@@ -27,4 +27,7 @@ HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
 HPX_REGISTER_ACTION_EX(
     had_stencil_value_out_adaptor_type::wrapped_type::get_value_action,
     had_stencil_value_out_get_value_action);
+HPX_REGISTER_ACTION_EX(
+    had_stencil_value_out_adaptor_type::wrapped_type::signal_action,
+    had_stencil_value_out_signal_action);
 
@@ -11,12 +11,23 @@
 #include <hpx/runtime/threads/thread.hpp>
 #include <hpx/runtime/components/component_type.hpp>
 #include <hpx/runtime/components/server/managed_component_base.hpp>
+#include <hpx/runtime/actions/component_action.hpp>
 
 #include <boost/function.hpp>
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr { namespace server 
 {
+    ///////////////////////////////////////////////////////////////////////////
+    // the events exchanged by the ports of the stencils computing their
+    // updates as continuations of their inputs (par->dataflow == 1)
+    enum port_event
+    {
+        port_connect = 0,     // consumer in-port subscribes to an out-port
+        port_value = 1,       // out-port delivers the value with the given count
+        port_release = 2      // consumer is done with the value with the given count
+    };
+
     ///////////////////////////////////////////////////////////////////////////
     class HPX_COMPONENT_EXPORT stencil_value_out_adaptor
       : public components::detail::managed_component_base<
@@ -25,13 +36,17 @@ namespace hpx { namespace components { namespace amr { namespace server
     {
     private:
         typedef boost::function<naming::id_type()> callback_function_type;
+        typedef boost::function<
+            void(int, std::size_t, naming::id_type const&)
+        > event_function_type;
         typedef components::detail::managed_component_base<
             stencil_value_out_adaptor
         > base_type;
         
     public:
-        stencil_value_out_adaptor(callback_function_type eval = callback_function_type())
-          : eval_(eval)
+        stencil_value_out_adaptor(callback_function_type eval = callback_function_type(),
+                event_function_type event = event_function_type())
+          : eval_(eval), event_(event)
         {
             if (component_invalid == base_type::get_component_type()) {
                 // first call to get_component_type, ask AGAS for a unique id
@@ -46,6 +61,7 @@ namespace hpx { namespace components { namespace amr { namespace server
         enum actions
         {
             stencil_value_out_get_value = 0,
+            stencil_value_out_signal = 1,
         };
 
         /// This is the main entry point of this component. Calling this 
@@ -57,6 +73,14 @@ namespace hpx { namespace components { namespace amr { namespace server
             return eval_();
         }
 
+        /// Deliver one of the port_event's to the stencil this port belongs
+        /// to, the events are handled even after the stencil is gone.
+        void signal(int event, std::size_t count, naming::id_type const& gid)
+        {
+            BOOST_ASSERT(event_);     // must have been initialized
+            event_(event, count, gid);
+        }
+
         // Each of the exposed functions needs to be encapsulated into an action
         // type, allowing to generate all required boilerplate code for threads,
         // serialization, etc.
@@ -65,14 +89,24 @@ namespace hpx { namespace components { namespace amr { namespace server
             stencil_value_out_get_value, &stencil_value_out_adaptor::get_value
         > get_value_action;
 
+        typedef hpx::actions::action3<
+            stencil_value_out_adaptor, stencil_value_out_signal,
+            int, std::size_t, naming::id_type const&,
+            &stencil_value_out_adaptor::signal
+        > signal_action;
+
     private:
         callback_function_type eval_;
+        event_function_type event_;
     };
 }}}}
 
 HPX_REGISTER_ACTION_DECLARATION_EX(
     hpx::components::amr::server::stencil_value_out_adaptor::get_value_action,
     had_stencil_value_out_get_value_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::server::stencil_value_out_adaptor::signal_action,
+    had_stencil_value_out_signal_action);
 
 #endif
 
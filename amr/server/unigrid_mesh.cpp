@@ -14,8 +14,11 @@
 #include <boost/serialization/export.hpp>
 #include <boost/assign/std/vector.hpp>
 
+#include <algorithm>
+
 #include "../dynamic_stencil_value.hpp"
 #include "../functional_component.hpp"
+#include "../performance_counters.hpp"
 #include "../../parameter.hpp"
 
 #include "unigrid_mesh.hpp"
@@ -190,12 +193,41 @@ namespace hpx { namespace components { namespace amr { namespace server
         for (std::size_t i = 0; function != functions.second; ++function, ++i)
         {
             lazyvals.push_back(components::amr::stubs::functional_component::
-                alloc_data_async(*function, i, numvalues, 0,par));
+                alloc_data_async(*function, i, numvalues, 0, i, par));
         }
 
         hpx::lcos::wait (lazyvals, initial_data);      // now wait for the results
     }
 
+    ///////////////////////////////////////////////////////////////////////////////
+    // let one of the functions on each locality release what was kept for
+    // creating the initial data
+    void unigrid_mesh::release_initial_data(
+        distributed_iterator_range_type const& functions,
+        Parameter const& par)
+    {
+        typedef std::vector<lcos::future<void> > lazyvals_type;
+
+        lazyvals_type lazyvals;
+        std::vector<naming::id_type> localities;
+        components::distributing_factory::iterator_type function = functions.first;
+        for (/**/; function != functions.second; ++function)
+        {
+            naming::id_type locality = naming::get_locality_from_id(*function);
+            if (std::find(localities.begin(), localities.end(), locality) !=
+                localities.end())
+            {
+                continue;
+            }
+            localities.push_back(locality);
+
+            lazyvals.push_back(components::amr::stubs::functional_component::
+                release_data_async(*function, par));
+        }
+
+        hpx::lcos::wait (lazyvals);      // now wait for the results
+    }
+
     ///////////////////////////////////////////////////////////////////////////////
     // do actual work
     void unigrid_mesh::execute(
@@ -239,32 +271,151 @@ namespace hpx { namespace components { namespace amr { namespace server
         hpx::lcos::wait (lazyvals);      // now wait for the results
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    double unigrid_mesh::column_cost(Parameter const& par,
+        std::vector<std::size_t> const& each_row, std::size_t column)
+    {
+        // the cost of a point update depends on the precision only, which is
+        // the same for all columns
+        std::size_t rows = 0;
+        for (std::size_t i = 0; i < each_row.size(); ++i) {
+            if (column < each_row[i])
+                ++rows;
+        }
+
+        int level = level_of_column(*par.p, column);
+        BOOST_ASSERT(level >= 0);
+        return double(rows) * par->granularity_level[level];
+    }
+
+    void unigrid_mesh::partition_columns(Parameter const& par,
+        std::size_t num_localities, std::vector<std::size_t>& bounds)
+    {
+        std::size_t numvalues = par->rowsize[0];
+
+        bounds.resize(num_localities + 1);
+        if (par->placement != 2 || numvalues < num_localities) {
+            for (std::size_t l = 0; l <= num_localities; ++l)
+                bounds[l] = l * numvalues / num_localities;
+            return;
+        }
+
+        std::vector<std::size_t> each_row, level_row;
+        row_layout(par, each_row, level_row);
+
+        std::vector<double> cost(numvalues);
+        double total = 0.0;
+        for (std::size_t c = 0; c < numvalues; ++c) {
+            cost[c] = column_cost(par, each_row, c);
+            total += cost[c];
+        }
+
+        // close a range as soon as its share of the total cost is reached,
+        // while leaving at least one column for each remaining locality
+        bounds[0] = 0;
+        std::size_t c = 0;
+        double accumulated = 0.0;
+        for (std::size_t l = 1; l < num_localities; ++l)
+        {
+            double target = total * l / num_localities;
+            while (c < numvalues - (num_localities - l) &&
+                   (c < bounds[l-1] + 1 || accumulated + cost[c]/2 < target))
+            {
+                accumulated += cost[c];
+                ++c;
+            }
+            bounds[l] = c;
+        }
+        bounds[num_localities] = numvalues;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    unigrid_mesh::result_type unigrid_mesh::create_components(
+        components::distributing_factory& factory,
+        components::component_type type, std::size_t count,
+        std::vector<naming::id_type> const& localities,
+        std::vector<std::size_t> const& bounds, Parameter const& par)
+    {
+        if (par->placement == 0)
+            return factory.create_components(type, count);
+
+        BOOST_ASSERT(bounds.size() == localities.size() + 1);
+
+        typedef std::vector<naming::gid_type> gids_type;
+        typedef std::vector<lcos::future<gids_type> > lazyvals_type;
+
+        // create the components for each column range on its locality
+        lazyvals_type lazyvals;
+        std::vector<std::size_t> used;
+        for (std::size_t l = 0; l < localities.size(); ++l)
+        {
+            std::size_t first = (std::min)(bounds[l], count);
+            std::size_t last = (std::min)(bounds[l+1], count);
+            if (first == last)
+                continue;
+
+            lazyvals.push_back(components::stubs::runtime_support::
+                bulk_create_components_async(localities[l], type, last - first));
+            used.push_back(l);
+        }
+
+        std::vector<gids_type> gids;
+        hpx::lcos::wait(lazyvals, gids);
+
+        // the components are enumerated in the order of the localities, which
+        // is the order of the columns
+        result_type result;
+        for (std::size_t i = 0; i < used.size(); ++i)
+        {
+            components::server::locality_result r;
+            r.prefix_ = localities[used[i]].get_gid();
+            r.gids_ = gids[i];
+            r.type_ = type;
+            result.push_back(r);
+        }
+        return result;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     /// This is the main entry point of this component.
-    std::vector<naming::id_type> unigrid_mesh::init_execute(
+    evolution_result unigrid_mesh::init_execute(
         components::component_type function_type, std::size_t numvalues,
         std::size_t numsteps,
         components::component_type logging_type,
-        Parameter const& par)
+        Parameter const& par_in)
     {
-        //hpx::util::high_resolution_timer t;
-        std::vector<naming::id_type> result_data;
+        evolution_result result;
+
+        // the parameters are amended by the placement of the columns
+        Parameter par;
+        *par.p = *par_in.p;
+
+        // forget about an earlier cancellation of this evolution
+        reset_evolution(par->evolution_id);
 
         components::component_type stencil_type =
             components::get_component_type<components::amr::server::dynamic_stencil_value>();
 
         typedef components::distributing_factory::result_type result_type;
 
+        phase_timer create_timer(phase_create_components);
+
         // create a distributing factory locally
         components::distributing_factory factory;
         factory.create(applier::get_applier().get_runtime_support_gid());
 
+        // place the column ranges on the localities
+        std::vector<naming::id_type> localities = hpx::find_all_localities();
+        std::vector<std::size_t> bounds;
+        partition_columns(par, localities.size(), bounds);
+        par->locality_bounds = bounds;
+
         // create a couple of stencil (functional) components and twice the
         // amount of stencil_value components
-        result_type functions = factory.create_components(function_type, numvalues);
+        result_type functions = create_components(factory, function_type,
+            numvalues, localities, bounds, par);
 
-        double tmp = 2*pow(2.0,par->allowedl);
-        int num_rows = (int) tmp;
+        int num_rows = num_rows_for(par);
 
         // Each row potentially has a different number of points depending on the
         // number of levels of refinement.  There are 2^(nlevel) rows each timestep;
@@ -306,23 +457,12 @@ namespace hpx { namespace components { namespace amr { namespace server
 
         std::vector<std::size_t> each_row;
         std::vector<std::size_t> level_row;
-        for (int i=0;i<num_rows;i++) {
-          int level = -1;
-          for (int j=par->allowedl;j>=0;j--) {
-            tmp = pow(2.0,j);
-            int tmp2 = (int) tmp;
-            if ( i%tmp2 == 0 ) {
-              level = par->allowedl-j;
-              level_row.push_back(level);
-              break;
-            }
-          }
-          each_row.push_back(par->rowsize[level]);
-        }
+        row_layout(par, each_row, level_row);
 
         std::vector<result_type> stencils;
         for (int i=0;i<num_rows;i++) {
-          stencils.push_back(factory.create_components(stencil_type, each_row[i]));
+          stencils.push_back(create_components(factory, stencil_type,
+              each_row[i], localities, bounds, par));
         }
 
         // initialize logging functionality in functions
@@ -331,8 +471,10 @@ namespace hpx { namespace components { namespace amr { namespace server
             logging = factory.create_components(logging_type);
 
         init(locality_results(functions), locality_results(logging), numsteps);
+        create_timer.stop();
 
         // prep the connections
+        phase_timer prep_timer(phase_prep_ports);
         std::size_t memsize = 6;
         Array3D dst_port(num_rows,each_row[0],memsize);
         Array3D dst_src(num_rows,each_row[0],memsize);
@@ -341,34 +483,51 @@ namespace hpx { namespace components { namespace amr { namespace server
         Array3D src_size(num_rows,each_row[0],1);
         prep_ports(dst_port,dst_src,dst_step,dst_size,src_size,
                    num_rows,each_row,level_row,par);
+        prep_timer.stop();
 
         // initialize stencil_values using the stencil (functional) components
+        phase_timer init_timer(phase_init_stencils);
         for (int i = 0; i < num_rows; ++i)
             init_stencils(locality_results(stencils[i]), locality_results(functions), i,
                           dst_port,dst_src,dst_step,dst_size,src_size, par);
+        init_timer.stop();
 
         // ask stencil instances for their output gids
+        phase_timer output_timer(phase_get_output_ports);
         std::vector<std::vector<std::vector<naming::id_type> > > outputs(num_rows);
         for (int i = 0; i < num_rows; ++i)
             get_output_ports(locality_results(stencils[i]), outputs[i]);
+        output_timer.stop();
 
         // connect output gids with corresponding stencil inputs
+        phase_timer connect_timer(phase_connect_input_ports);
         connect_input_ports(&*stencils.begin(), outputs,dst_size,dst_step,dst_src,dst_port,par);
+        connect_timer.stop();
 
         // for loop over second row ; call start for each
+        phase_timer start_timer(phase_start_row);
         for (int i = 1; i < num_rows; ++i)
             start_row(locality_results(stencils[i]));
+        start_timer.stop();
 
         // prepare initial data
+        phase_timer initial_data_timer(phase_prepare_initial_data);
         std::vector<naming::id_type> initial_data;
         prepare_initial_data(locality_results(functions), initial_data,
                              each_row[0],par);
+        release_initial_data(locality_results(functions), par);
+        initial_data_timer.stop();
 
-        //std::cout << " Startup grid cost " << t.elapsed() << std::endl;
         // do actual work
-        execute(locality_results(stencils[0]), initial_data, result_data);
+        phase_timer execute_timer(phase_execute);
+        execute(locality_results(stencils[0]), initial_data, result.result_data_);
+        execute_timer.stop();
+
+        // the evolution may have been cancelled by any of the localities
+        result.status_ = query_evolution(par->evolution_id);
 
         // free all allocated components (we can do that synchronously)
+        phase_timer free_timer(phase_free_components);
         if (!logging.empty())
             factory.free_components_sync(logging);
 
@@ -376,7 +535,7 @@ namespace hpx { namespace components { namespace amr { namespace server
             factory.free_components_sync(stencils[i]);
         factory.free_components_sync(functions);
 
-        return result_data;
+        return result;
     }
 
     ///////////////////////////////////////////////////////////////////////////
@@ -459,6 +618,24 @@ namespace hpx { namespace components { namespace amr { namespace server
 
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    int unigrid_mesh::num_rows_for(Parameter const& par)
+    {
+        return 2 << par->allowedl;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The number of points (each_row) and the finest level (level_row) of
+    // each of the rows of the mesh are computed along with the other derived
+    // parameters
+    void unigrid_mesh::row_layout(Parameter const& par,
+        std::vector<std::size_t>& each_row, std::vector<std::size_t>& level_row)
+    {
+        BOOST_ASSERT(par->each_row.size() == std::size_t(num_rows_for(par)));
+        each_row = par->each_row;
+        level_row = par->level_row;
+    }
+
     void unigrid_mesh::prep_ports(Array3D &dst_port,Array3D &dst_src,
                                   Array3D &dst_step,Array3D &dst_size,Array3D &src_size,std::size_t num_rows,
                                   std::vector<std::size_t> &each_row,std::vector<std::size_t> &level_row,
@@ -488,13 +665,7 @@ namespace hpx { namespace components { namespace amr { namespace server
           counter = 0;
 
           // discover what level to which this point belongs
-          int level = -1;
-          for (j=0;j<=par->allowedl;j++) {
-            if ( i >= par->level_begin[j] && i < par->level_end[j] ) {
-              level = j;
-              break;
-            }
-          }
+          int level = level_of_column(*par.p, i);
           BOOST_ASSERT(level >= 0);
 
           // communicate three
@@ -521,13 +692,7 @@ namespace hpx { namespace components { namespace amr { namespace server
 
               // verify that, if we are sending data to a different level,
               // there are two finer mesh timesteps between the source row and destination row:
-              int level_j = -1;
-              for (k=0;k<=par->allowedl;k++) {
-                if ( j >= par->level_begin[k] && j < par->level_end[k] ) {
-                  level_j = k;
-                  break;
-                }
-              }
+              int level_j = level_of_column(*par.p, j);
 
               if ( level >= 0 && level_j >= 0 ) {
                 // If level == level_j, no verification is needed (the source and destination level are
@@ -538,8 +703,7 @@ namespace hpx { namespace components { namespace amr { namespace server
                   int difference = dst - step;
                   if ( dst == 0 ) difference = num_rows - step;
 
-                  double tmp = pow(2.0,par->allowedl-level);
-                  int cmp = (int) tmp;
+                  int cmp = int(level_timestep(*par.p, level));
                   if ( difference != 2*cmp ) {
                     dst = -1;
                   }
@@ -15,6 +15,7 @@
 #include <hpx/components/distributing_factory/distributing_factory.hpp>
 
 #include "../../parameter.hpp"
+#include "../cancellation.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr { namespace server
@@ -42,8 +43,10 @@ namespace hpx { namespace components { namespace amr { namespace server
             unigrid_mesh_execute = 1
         };
 
-        /// This is the main entry point of this component.
-        std::vector<naming::id_type> init_execute(
+        /// This is the main entry point of this component. It returns the
+        /// memory blocks of the last time step and the way the evolution
+        /// ended.
+        evolution_result init_execute(
             components::component_type function_type, std::size_t numvalues,
             std::size_t numsteps,
             components::component_type logging_type,
@@ -60,7 +63,7 @@ namespace hpx { namespace components { namespace amr { namespace server
         // type, allowing to generate all required boilerplate code for threads,
         // serialization, etc.
         typedef hpx::actions::result_action5<
-            unigrid_mesh, std::vector<naming::id_type>, unigrid_mesh_init_execute,
+            unigrid_mesh, evolution_result, unigrid_mesh_init_execute,
             components::component_type, std::size_t, std::size_t,
             components::component_type,
             Parameter const&, &unigrid_mesh::init_execute
@@ -88,6 +91,10 @@ namespace hpx { namespace components { namespace amr { namespace server
             std::size_t numvalues,
             Parameter const& par);
 
+        static void release_initial_data(
+            distributed_iterator_range_type const& functions,
+            Parameter const& par);
+
         static void init_stencils(
             distributed_iterator_range_type const& stencils,
             distributed_iterator_range_type const& functions, int static_step,
@@ -110,6 +117,45 @@ namespace hpx { namespace components { namespace amr { namespace server
 
         static void start_row(distributed_iterator_range_type const& stencils);
 
+        typedef components::distributing_factory::result_type result_type;
+
+        /// Create \a count components of the given type, one for each of the
+        /// first \a count columns. Depending on par->placement these are
+        /// either distributed by the factory or placed by column ranges
+        /// given by \a bounds (see partition_columns).
+        static result_type create_components(
+            components::distributing_factory& factory,
+            components::component_type type, std::size_t count,
+            std::vector<naming::id_type> const& localities,
+            std::vector<std::size_t> const& bounds, Parameter const& par);
+
+    public:
+        /// Split the columns of the mesh into contiguous ranges, one for each
+        /// locality: locality l gets the columns [bounds[l], bounds[l+1]).
+        /// The same column is placed on the same locality in all rows. For
+        /// par->placement == 2 the ranges have (roughly) equal cost, see
+        /// column_cost, otherwise an equal number of columns.
+        static void partition_columns(Parameter const& par,
+            std::size_t num_localities, std::vector<std::size_t>& bounds);
+
+        /// Return the relative cost of computing one column over a full
+        /// cycle through all rows: the number of rows it is computed in
+        /// (proportional to the number of steps on its level) times the
+        /// granularity of its level.
+        static double column_cost(Parameter const& par,
+            std::vector<std::size_t> const& each_row, std::size_t column);
+
+        /// Return the number of rows of the mesh (two per coarse timestep
+        /// for each level of refinement)
+        static int num_rows_for(Parameter const& par);
+
+        /// Compute the number of points and the finest level of each row
+        static void row_layout(Parameter const& par,
+            std::vector<std::size_t>& each_row,
+            std::vector<std::size_t>& level_row);
+
+        /// Compute the static data-flow structure connecting the output
+        /// ports of each row with the input ports of the rows consuming them
         static void prep_ports(Array3D &dst_port,Array3D &dst_src,
                                     Array3D &dst_step,Array3D &dst_size,
                                     Array3D &src_size,std::size_t num_rows,
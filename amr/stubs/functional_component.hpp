@@ -30,41 +30,43 @@ namespace hpx { namespace components { namespace amr { namespace stubs
         // functional component derived from this class
         static lcos::future<std::size_t> eval_async(naming::id_type const& gid,
             naming::id_type const& result, std::vector<naming::id_type> const& gids, 
-            std::size_t row, std::size_t column, Parameter const& par)
+            std::size_t row, std::size_t column, int kind, Parameter const& par)
         {
             // Create an eager_future, execute the required action,
             // we simply return the initialized future_value, the caller needs
             // to call get() on the return value to obtain the result
             typedef amr::server::functional_component::eval_action action_type;
-            return hpx::async<action_type>(gid, result, gids, row, column,par);
+            return hpx::async<action_type>(gid, result, gids, row, column,
+                kind, par);
         }
 
         static std::size_t eval(naming::id_type const& gid,
             naming::id_type const& result, std::vector<naming::id_type> const& gids,
-            std::size_t row, std::size_t column, Parameter const& par)
+            std::size_t row, std::size_t column, int kind, Parameter const& par)
         {
             // The following get yields control while the action above
             // is executed and the result is returned to the eager_future
-            return eval_async(gid, result, gids, row, column,par).get();
+            return eval_async(gid, result, gids, row, column, kind, par).get();
         }
 
         ///////////////////////////////////////////////////////////////////////
         static lcos::future<naming::id_type> alloc_data_async(
             naming::id_type const& gid, std::size_t item, std::size_t maxitems,
-            std::size_t row, Parameter const& par)
+            std::size_t row, std::size_t column, Parameter const& par)
         {
             // Create an eager_future, execute the required action,
             // we simply return the initialized future_value, the caller needs
             // to call get() on the return value to obtain the result
             typedef amr::server::functional_component::alloc_data_action action_type;
-            return hpx::async<action_type>(gid, item, maxitems, row, par);
+            return hpx::async<action_type>(gid, item, maxitems, row, column,
+                par);
         }
 
         static naming::id_type alloc_data(naming::id_type const& gid,
             std::size_t item, std::size_t maxitems, std::size_t row,
-            Parameter const& par)
+            std::size_t column, Parameter const& par)
         {
-            return alloc_data_async(gid, item, maxitems, row, par).get();
+            return alloc_data_async(gid, item, maxitems, row, column, par).get();
         }
 
         ///////////////////////////////////////////////////////////////////////
@@ -81,6 +83,20 @@ namespace hpx { namespace components { namespace amr { namespace stubs
         {
             init_async(gid, numsteps, val).get();
         }
+
+        ///////////////////////////////////////////////////////////////////////
+        static lcos::future<void>
+        release_data_async(naming::id_type const& gid, Parameter const& par)
+        {
+            typedef amr::server::functional_component::release_data_action action_type;
+            return hpx::async<action_type>(gid, par);
+        }
+
+        static void release_data(naming::id_type const& gid,
+            Parameter const& par)
+        {
+            release_data_async(gid, par).get();
+        }
     };
 }}}}
 
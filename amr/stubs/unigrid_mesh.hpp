@@ -26,7 +26,7 @@ namespace hpx { namespace components { namespace amr { namespace stubs
         // exposed functionality of this component
 
         ///////////////////////////////////////////////////////////////////////
-        static lcos::future<std::vector<naming::id_type> >
+        static lcos::future<evolution_result>
         init_execute_async(naming::id_type const& gid,
             components::component_type function_type, std::size_t numvalues,
             std::size_t numsteps, components::component_type logging_type,
@@ -40,7 +40,7 @@ namespace hpx { namespace components { namespace amr { namespace stubs
                 numvalues, numsteps, logging_type,par);
         }
 
-        static std::vector<naming::id_type> init_execute(naming::id_type const& gid,
+        static evolution_result init_execute(naming::id_type const& gid,
             components::component_type function_type, std::size_t numvalues,
             std::size_t numsteps, components::component_type logging_type,
             Parameter const& par)
@@ -0,0 +1,219 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <hpx/hpx.hpp>
+
+#include <boost/asio/ip/host_name.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "amr/unigrid_mesh.hpp"
+#include "amr/performance_counters.hpp"
+#include "amr_c/stencil.hpp"
+
+#include "amr_autotune.hpp"
+
+using namespace hpx;
+
+namespace autotune
+{
+    typedef components::amr::Parameter Parameter;
+
+    ///////////////////////////////////////////////////////////////////////////
+    std::string cache_key(Parameter const& par, int nx0)
+    {
+        std::ostringstream strm;
+        strm << boost::asio::ip::host_name()
+             << ":" << hpx::get_os_thread_count()
+             << ":" << hpx::find_all_localities().size()
+             << ":" << had_precision_name()
+             << ":" << nx0
+             << ":" << par->allowedl;
+
+        // the hierarchy, a granularity_level of 0 stands for the tuned one
+        strm << ":r";
+        for (int j = 0; j < par->allowedl; ++j)
+            strm << (j ? "," : "") << par->refine_level[j];
+        strm << ":g";
+        for (int j = 0; j <= par->allowedl; ++j)
+            strm << (j ? "," : "") << par->granularity_level[j];
+
+        // the way the mesh is executed
+        strm << ":" << par->placement
+             << ":" << par->pipeline_depth
+             << ":" << par->dataflow;
+        return strm.str();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // number of levels using the global granularity
+    int fallback_levels(Parameter const& par)
+    {
+        int levels = 0;
+        for (int j = 0; j <= par->allowedl; ++j) {
+            if (par->granularity_level[j] <= 0)
+                ++levels;
+        }
+        return levels;
+    }
+
+    // the coarse level has to be divided into whole blocks, unless it has
+    // an explicit granularity
+    bool divides_coarse_level(Parameter const& par, int nx0, int granularity)
+    {
+        return par->granularity_level[0] > 0 || nx0 % granularity == 0;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // the cache holds one line per calibration: key granularity seconds; if
+    // a key shows up more than once the last entry wins
+    bool read_cache(std::string const& key, int& granularity)
+    {
+        std::ifstream in(cache_filename);
+        if (!in)
+            return false;
+
+        bool found = false;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream strm(line);
+            std::string k;
+            int g = 0;
+            if ((strm >> k >> g) && k == key && g > 0) {
+                granularity = g;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void write_cache(std::string const& key, int granularity, double seconds)
+    {
+        std::ofstream out(cache_filename, std::ios::app);
+        if (!out) {
+            std::cerr << " autotune: unable to write " << cache_filename
+                      << std::endl;
+            return;
+        }
+        out << key << " " << granularity << " " << seconds << "\n";
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // number of point updates done by one coarse step of the whole mesh
+    double points_per_coarse_step(Parameter const& par)
+    {
+        double points = 0.0;
+        for (int j = 0; j <= par->allowedl; ++j) {
+            points += double(par->level_end[j] - par->level_begin[j]) *
+                par->granularity_level[j] * double(std::size_t(1) << j);
+        }
+        return points;
+    }
+
+    // run a short evolution for the given granularity from the initial data,
+    // returns the time per point and step (-1 if the granularity is rejected)
+    double calibrate(Parameter const& par, int nx0, int granularity,
+        std::size_t steps)
+    {
+        components::component_type function_type =
+            components::get_component_type<components::amr::stencil>();
+
+        // deep copy, the parameters are shared otherwise
+        Parameter cal;
+        *cal.p = *par.p;
+        cal->granularity = granularity;
+        cal->nt0 = steps;
+        cal->loglevel = 0;
+        cal->output_stdout = 0;
+        cal->checkpoint = 0;
+        cal->restart.clear();
+
+        // the granularity has to fit the other parameters
+        if (!components::amr::check_parameters(cal, nx0))
+            return -1.0;
+        components::amr::compute_derived_parameters(cal, nx0);
+
+        naming::id_type here = applier::get_applier().get_runtime_support_gid();
+
+        // only the execution phase is timed, creating, wiring and freeing
+        // the components would dominate the few calibration steps
+        boost::int64_t const start =
+            components::amr::get_phase_time(components::amr::phase_execute);
+        {
+            components::amr::unigrid_mesh unigrid_mesh;
+            unigrid_mesh.create(here);
+            unigrid_mesh.init_execute(function_type, cal->rowsize[0], steps,
+                components::component_invalid, cal);
+        }
+        boost::int64_t const usecs =
+            components::amr::get_phase_time(components::amr::phase_execute) - start;
+        return usecs * 1e-6 / (points_per_coarse_step(cal) * steps);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    int find_granularity(Parameter const& par, int nx0,
+        std::size_t calibration_steps)
+    {
+        // only the levels without an explicit granularity are tuned
+        if (fallback_levels(par) == 0) {
+            std::cout << " autotune: all levels have an explicit granularity, "
+                      << "keeping " << par->granularity << std::endl;
+            return par->granularity;
+        }
+
+        std::string key = cache_key(par, nx0);
+
+        int granularity = 0;
+        if (read_cache(key, granularity) &&
+            divides_coarse_level(par, nx0, granularity))
+        {
+            std::cout << " autotune: using cached granularity " << granularity
+                      << " for " << key << std::endl;
+            return granularity;
+        }
+
+        // at least three points per block and three blocks on the coarse level
+        double best = 0.0;
+        for (int g = 3; g <= nx0/3; ++g)
+        {
+            if (!divides_coarse_level(par, nx0, g))
+                continue;
+
+            double seconds = calibrate(par, nx0, g, calibration_steps);
+            if (seconds < 0.0) {
+                std::cout << " autotune: granularity " << g << " rejected"
+                          << std::endl;
+                continue;
+            }
+            std::cout << " autotune: granularity " << g << " : "
+                      << seconds << " s per point step" << std::endl;
+
+            if (granularity == 0 || seconds < best) {
+                granularity = g;
+                best = seconds;
+            }
+        }
+
+        // the calibration runs should not show up in the final statistics
+        components::amr::reset_performance_data();
+
+        if (granularity == 0) {
+            std::cerr << " autotune: no valid granularity for nx0 " << nx0
+                      << ", keeping " << par->granularity << std::endl;
+            return par->granularity;
+        }
+
+        write_cache(key, granularity, best);
+        std::cout << " autotune: selected granularity " << granularity
+                  << " for " << key << std::endl;
+        return granularity;
+    }
+}
@@ -0,0 +1,34 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HAD_AMR_AUTOTUNE_OCT_18_2012_0245PM)
+#define HAD_AMR_AUTOTUNE_OCT_18_2012_0245PM
+
+#include <string>
+
+#include "parameter.hpp"
+
+namespace autotune
+{
+    /// Name of the file the tuned granularities are persisted to.
+    char const* const cache_filename = "had_amr_autotune.cache";
+
+    /// Return the key identifying the current configuration in the cache
+    /// (host name, number of OS threads and localities, precision, nx0, the
+    /// refinement levels with their extents and explicit granularities,
+    /// placement, pipeline_depth and dataflow).
+    std::string cache_key(hpx::components::amr::Parameter const& par, int nx0);
+
+    /// Run short calibration evolutions for all granularities dividing nx0
+    /// (or look up a previous result in the cache) and return the one with
+    /// the smallest time per point and step. This has to be called before
+    /// compute_derived_parameters, levels with an explicit granularity
+    /// (granularity_level_N) keep it and only the other levels are tuned.
+    /// Nothing is tuned if all levels have an explicit granularity.
+    int find_granularity(hpx::components::amr::Parameter const& par, int nx0,
+        std::size_t calibration_steps);
+}
+
+#endif
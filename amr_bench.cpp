@@ -0,0 +1,399 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Micro-benchmarks for the building blocks of had_amr. All results are
+// written as a single JSON document, allowing to track regressions between
+// releases.
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/lcos/local/counting_semaphore.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+#include <hpx/util/portable_binary_iarchive.hpp>
+#include <hpx/util/portable_binary_oarchive.hpp>
+#include <hpx/components/distributing_factory/distributing_factory.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+
+#include "amr/functional_component.hpp"
+#include "amr/unigrid_mesh.hpp"
+#include "amr_c/stencil.hpp"
+#include "amr_c/stencil_data.hpp"
+#include "amr_c_test/stencil_functions.hpp"
+
+namespace po = boost::program_options;
+
+using namespace hpx;
+
+///////////////////////////////////////////////////////////////////////////////
+namespace bench
+{
+    typedef components::amr::Parameter Parameter;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // collect all results as JSON objects
+    class results
+    {
+    public:
+        void add(std::string const& name, std::string const& params,
+            std::size_t iterations, double elapsed)
+        {
+            std::ostringstream strm;
+            strm << "    { \"name\": \"" << name << "\", "
+                 << params << (params.empty() ? "" : ", ")
+                 << "\"iterations\": " << iterations << ", "
+                 << "\"seconds_per_iteration\": "
+                 << (iterations ? elapsed / iterations : 0.0) << " }";
+            entries_.push_back(strm.str());
+        }
+
+        void write(std::ostream& os) const
+        {
+            os << "{\n"
+               << "  \"localities\": " << hpx::find_all_localities().size() << ",\n"
+               << "  \"os_threads\": " << hpx::get_os_thread_count() << ",\n"
+               << "  \"benchmarks\": [\n";
+            for (std::size_t i = 0; i < entries_.size(); ++i)
+            {
+                os << entries_[i]
+                   << (i+1 != entries_.size() ? ",\n" : "\n");
+            }
+            os << "  ]\n}\n";
+        }
+
+    private:
+        std::vector<std::string> entries_;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // set up a parameter set using the defaults of had_amr_client
+    Parameter make_parameters(int granularity, int allowedl, int nx0)
+    {
+        Parameter par;
+        int default_nx0;
+        components::amr::set_default_parameters(par, default_nx0, 100);
+        par->allowedl    = allowedl;
+        par->loglevel    = 0;
+        par->eps         =  0.3;
+        par->granularity = granularity;
+        par->placement   = 1;
+
+        if (!components::amr::check_parameters(par, nx0)) {
+            HPX_THROW_EXCEPTION(bad_parameter, "bench::make_parameters",
+                "the parameters of the benchmark are rejected");
+        }
+
+        components::amr::compute_derived_parameters(par, nx0);
+        return par;
+    }
+
+    std::string granularity_params(int granularity)
+    {
+        return "\"granularity\": " +
+            boost::lexical_cast<std::string>(granularity) +
+            ", \"precision\": \"" + had_precision_name() + "\"";
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // time a single RK update of an interior block (all three RK stages)
+    void rkupdate_benchmark(results& r, int granularity, std::size_t iterations)
+    {
+        Parameter par = make_parameters(granularity, 0, 3*granularity);
+
+        stencil_data data[3];
+        for (std::size_t i = 0; i < 3; ++i)
+            generate_initial_data(&data[i], i, 3, 0, *par.p);
+
+        std::vector<had_double_type> x;
+        std::vector<nodedata*> vecval;
+        for (std::size_t i = 0; i < 3; ++i) {
+            for (std::size_t j = 0; j < data[i].granularity; ++j) {
+                x.push_back(point_x(*par.p, 0, i, j));
+                vecval.push_back(&data[i].value_[j]);
+            }
+        }
+
+        std::vector<had_double_type*> vecx;
+        for (std::size_t i = 0; i < x.size(); ++i)
+            vecx.push_back(&x[i]);
+
+        stencil_data result(data[1]);
+
+        hpx::util::high_resolution_timer t;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            rkupdate(vecval, &result, vecx, vecval.size(), stencil_interior,
+                granularity, par->dt0, par->dx0, 0, 0, *par.p);
+        }
+        r.add("rkupdate", granularity_params(granularity), iterations,
+            t.elapsed());
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // time stencil::eval (through its action) for interior points, physical
+    // boundaries and both ghost zone treatments at coarse-fine interfaces
+    void eval_benchmark(results& r, int granularity, std::size_t iterations)
+    {
+        typedef components::distributing_factory::result_type result_type;
+
+        // one level of refinement: 12 coarse blocks, 18 fine blocks
+        Parameter par = make_parameters(granularity, 1, 12*granularity);
+        std::size_t numvalues = par->rowsize[0];
+
+        components::component_type function_type =
+            components::get_component_type<components::amr::stencil>();
+
+        components::distributing_factory factory;
+        factory.create(find_here());
+
+        result_type functions = factory.create_components(function_type, 1);
+        naming::id_type function = *locality_results(functions).first;
+
+        namespace stubs = components::amr::stubs;
+        stubs::functional_component::init(function, par->nt0, naming::invalid_id);
+
+        std::vector<naming::id_type> blocks;
+        for (std::size_t i = 0; i < numvalues; ++i) {
+            blocks.push_back(stubs::functional_component::alloc_data(
+                function, i, numvalues, 0, i, par));
+        }
+
+        struct eval_case
+        {
+            char const* name;
+            std::size_t column;
+            std::size_t first, count;      // columns of the input blocks
+        };
+
+        std::size_t interface = par->level_begin[0];
+        eval_case const cases[] =
+        {
+            { "interior",          interface/2,   interface/2-1, 3 },
+            { "left_boundary",     0,             0,             2 },
+            { "right_boundary",    numvalues-1,   numvalues-2,   2 },
+            { "ghost_restriction", interface,     interface-1,   3 },
+            { "ghost_prolongation", interface-1,  interface-2,   3 }
+        };
+
+        for (std::size_t c = 0; c < sizeof(cases)/sizeof(cases[0]); ++c)
+        {
+            std::vector<naming::id_type> gids(blocks.begin() + cases[c].first,
+                blocks.begin() + cases[c].first + cases[c].count);
+
+            naming::id_type result = stubs::functional_component::alloc_data(
+                function, -1, -1, 0, cases[c].column, par);
+
+            // the kind is fixed for each stencil, it is not part of the timing
+            int const kind = get_stencil_kind(*par.p, cases[c].column,
+                gids.size());
+
+            hpx::util::high_resolution_timer t;
+            for (std::size_t i = 0; i < iterations; ++i)
+            {
+                stubs::functional_component::eval(function, result, gids,
+                    0, cases[c].column, kind, par);
+            }
+            double elapsed = t.elapsed();
+
+            r.add(std::string("stencil_eval_") + cases[c].name,
+                granularity_params(granularity), iterations, elapsed);
+        }
+
+        // the memory blocks are released as soon as the last reference
+        // goes out of scope
+        blocks.clear();
+        factory.free_components_sync(functions);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // time the serialization of a full block (this is what is sent over the
+    // wire whenever a neighbor is remote)
+    void serialization_benchmark(results& r, int granularity,
+        std::size_t iterations)
+    {
+        Parameter par = make_parameters(granularity, 0, 3*granularity);
+
+        stencil_data data;
+        generate_initial_data(&data, 1, 3, 0, *par.p);
+
+        std::size_t bytes = 0;
+        hpx::util::high_resolution_timer t;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            std::vector<char> buffer;
+            {
+                hpx::util::portable_binary_oarchive archive(buffer);
+                archive << data;
+            }
+            bytes = buffer.size();
+
+            stencil_data copy;
+            {
+                hpx::util::portable_binary_iarchive archive(buffer);
+                archive >> copy;
+            }
+        }
+        double elapsed = t.elapsed();
+
+        r.add("serialize_stencil_data", granularity_params(granularity) +
+            ", \"bytes\": " + boost::lexical_cast<std::string>(bytes),
+            iterations, elapsed);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // time the computation of the data-flow structure of the mesh
+    void prep_ports_benchmark(results& r, int allowedl, int nx0,
+        std::size_t iterations)
+    {
+        typedef components::amr::server::unigrid_mesh mesh_type;
+
+        Parameter par = make_parameters(3, allowedl, nx0);
+
+        std::vector<std::size_t> each_row, level_row;
+        mesh_type::row_layout(par, each_row, level_row);
+        std::size_t num_rows = each_row.size();
+
+        hpx::util::high_resolution_timer t;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            std::size_t memsize = 6;
+            Array3D dst_port(num_rows,each_row[0],memsize);
+            Array3D dst_src(num_rows,each_row[0],memsize);
+            Array3D dst_step(num_rows,each_row[0],memsize);
+            Array3D dst_size(num_rows,each_row[0],1);
+            Array3D src_size(num_rows,each_row[0],1);
+            mesh_type::prep_ports(dst_port,dst_src,dst_step,dst_size,src_size,
+                num_rows,each_row,level_row,par);
+        }
+        double elapsed = t.elapsed();
+
+        std::ostringstream params;
+        params << "\"allowedl\": " << allowedl << ", \"nx0\": " << nx0
+               << ", \"rows\": " << num_rows
+               << ", \"columns\": " << each_row[0];
+        r.add("prep_ports", params.str(), iterations, elapsed);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // time the semaphore handshake used by dynamic_stencil_value to hand a
+    // value from the driver thread to an output port and back
+    void semaphore_pong(lcos::local::counting_semaphore& in,
+        lcos::local::counting_semaphore& out,
+        lcos::local::counting_semaphore& done, std::size_t iterations)
+    {
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            in.wait();
+            out.signal();
+        }
+        done.signal();
+    }
+
+    void semaphore_benchmark(results& r, std::size_t iterations)
+    {
+        lcos::local::counting_semaphore sem_out(0), sem_in(0), done(0);
+
+        applier::register_thread_nullary(
+            boost::bind(&semaphore_pong, boost::ref(sem_out),
+                boost::ref(sem_in), boost::ref(done), iterations),
+            "had_amr_bench::semaphore_pong");
+
+        hpx::util::high_resolution_timer t;
+        for (std::size_t i = 0; i < iterations; ++i)
+        {
+            sem_out.signal();
+            sem_in.wait();
+        }
+        double elapsed = t.elapsed();
+
+        done.wait();
+        r.add("semaphore_round_trip", "", iterations, elapsed);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(po::variables_map& vm)
+{
+    std::size_t iterations = vm["iterations"].as<std::size_t>();
+
+    bench::results r;
+    int const granularities[] = { 3, 9, 15, 30, 60, 120 };
+    std::size_t const num_granularities =
+        sizeof(granularities)/sizeof(granularities[0]);
+
+#if defined(MPFR_FOUND) && !defined(HAD_AMR_USE_MPET)
+    // note: the constants used inside the kernels are created with the
+    // precision active during their first use
+    int const precisions[] = { 64, 128, 256 };
+    for (std::size_t p = 0; p < sizeof(precisions)/sizeof(precisions[0]); ++p)
+    {
+        mpfr::mpreal::set_default_prec(precisions[p]);
+        for (std::size_t i = 0; i < num_granularities; ++i)
+            bench::rkupdate_benchmark(r, granularities[i], iterations);
+    }
+    mpfr::mpreal::set_default_prec(128);
+#else
+    for (std::size_t i = 0; i < num_granularities; ++i)
+        bench::rkupdate_benchmark(r, granularities[i], iterations);
+#endif
+
+    for (std::size_t i = 0; i < num_granularities; ++i)
+        bench::eval_benchmark(r, granularities[i], iterations);
+
+    for (std::size_t i = 0; i < num_granularities; ++i)
+        bench::serialization_benchmark(r, granularities[i], iterations);
+
+    for (int allowedl = 0; allowedl <= 3; ++allowedl)
+    {
+        for (int nx0 = 60; nx0 <= 960; nx0 *= 2)
+            bench::prep_ports_benchmark(r, allowedl, nx0, 1);
+    }
+
+    bench::semaphore_benchmark(r, 100*iterations);
+
+    if (vm.count("output")) {
+        std::string filename = vm["output"].as<std::string>();
+        std::ofstream out(filename.c_str());
+        r.write(out);
+    }
+    else {
+        r.write(std::cout);
+    }
+
+    return hpx::finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    try {
+        po::options_description desc_cmdline ("Usage: had_amr_bench [options]");
+        desc_cmdline.add_options()
+            ("iterations,i", po::value<std::size_t>()->default_value(100),
+                "the number of iterations to time for each micro-benchmark")
+            ("output,o", po::value<std::string>(),
+                "write the JSON results to the given file (default: stdout)")
+        ;
+
+        return hpx::init(desc_cmdline, argc, argv);
+    }
+    catch (std::exception& e) {
+        std::cerr << "std::exception caught: " << e.what() << "\n";
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "unexpected exception caught\n";
+        return -2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,176 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <hpx/hpx.hpp>
+
+#include "amr/unigrid_mesh.hpp"
+#include "amr/cancellation.hpp"
+#include "amr_c/stencil.hpp"
+#include "amr_c/logging.hpp"
+
+#include "amr_bisection.hpp"
+
+using namespace hpx;
+
+namespace bisection
+{
+    typedef components::amr::Parameter Parameter;
+
+    // the evolution ids handed out to the members, 0 is the id of the single
+    // evolution of had_amr_client
+    std::size_t next_evolution_id = 1;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // set up the parameters of the evolution for the given amplitude, the
+    // members neither log nor checkpoint
+    Parameter make_member(Parameter const& par, double amp)
+    {
+        // deep copy, the parameters are shared otherwise
+        Parameter member;
+        *member.p = *par.p;
+        member->amp = amp;
+        member->evolution_id = next_evolution_id++;
+        member->loglevel = 0;
+        member->output_stdout = 0;
+        member->checkpoint = 0;
+        member->checkpoint_every = 0;
+        member->restart.clear();
+        return member;
+    }
+
+    // compute the evolutions for the given amplitudes concurrently, return
+    // whether each of them collapsed
+    std::vector<bool> run_members(Parameter const& par, std::size_t numsteps,
+        std::vector<double> const& amps)
+    {
+        components::component_type function_type =
+            components::get_component_type<components::amr::stencil>();
+
+        // the dispersal is detected by the logging instance of each member
+        components::component_type logging_type = components::component_invalid;
+        if (par->diagnostics) {
+            logging_type =
+                components::get_component_type<components::amr::server::logging>();
+        }
+
+        naming::id_type here = applier::get_applier().get_runtime_support_gid();
+
+        // Only the derived parameters are shared by the members, each member
+        // creates and wires its own mesh. The members run concurrently, so
+        // their stencils and values can't be shared, and building the port
+        // tables costs little compared to the evolution itself.
+        std::vector<components::amr::unigrid_mesh> meshes(amps.size());
+        std::vector<lcos::future<components::amr::evolution_result> > results;
+        for (std::size_t i = 0; i < amps.size(); ++i)
+        {
+            Parameter member = make_member(par, amps[i]);
+            if (member->diagnostics) {
+                FILE *fdata = fopen(components::amr::diagnostics_filename(
+                    *member.p).c_str(),"w");
+                fprintf(fdata,"# time energy max|chi| x(max|chi|)\n");
+                fclose(fdata);
+            }
+
+            meshes[i].create(here);
+            results.push_back(meshes[i].init_execute_async(function_type,
+                member->rowsize[0], numsteps, logging_type, member));
+        }
+
+        std::vector<bool> collapsed;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            components::amr::evolution_status status = results[i].get().status_;
+            std::cout << " bisection: amp " << amps[i] << " : "
+                      << components::amr::get_outcome_name(status.outcome_)
+                      << std::endl;
+            collapsed.push_back(
+                status.outcome_ == components::amr::evolution_collapsed);
+        }
+        return collapsed;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    bracket find_critical_amplitude(Parameter const& par,
+        std::size_t numsteps, settings const& s)
+    {
+        bracket result;
+        result.subcritical_ = s.amp_min_;
+        result.supercritical_ = s.amp_max_;
+
+        std::size_t const width = (s.width_ < 2) ? 2 : s.width_;
+
+        // the members differ in their amplitude only, which has to pass the
+        // checks at both ends of the interval
+        int const nx0 = par->nx0*par->granularity_level[0];
+        if (!components::amr::check_parameters(make_member(par, s.amp_min_), nx0) ||
+            !components::amr::check_parameters(make_member(par, s.amp_max_), nx0))
+        {
+            std::cerr << " bisection: invalid parameters" << std::endl;
+            return result;
+        }
+
+        for (std::size_t it = 0; it < s.iterations_; ++it)
+        {
+            double const lo = result.subcritical_;
+            double const hi = result.supercritical_;
+
+            // the amplitudes are spread evenly, the first iteration includes
+            // both ends of the interval
+            std::vector<double> amps;
+            for (std::size_t i = 0; i < width; ++i) {
+                if (it == 0)
+                    amps.push_back(lo + (hi - lo)*i/(width - 1));
+                else
+                    amps.push_back(lo + (hi - lo)*(i + 1)/(width + 1));
+            }
+
+            std::vector<bool> collapsed = run_members(par, numsteps, amps);
+            result.evolutions_ += amps.size();
+
+            // the new interval reaches from the largest amplitude which did
+            // not collapse to the smallest one which did
+            bool found_super = (it != 0);
+            double new_hi = hi;
+            for (std::size_t i = 0; i < amps.size(); ++i) {
+                if (collapsed[i]) {
+                    new_hi = amps[i];
+                    found_super = true;
+                    break;
+                }
+            }
+
+            bool found_sub = (it != 0);
+            double new_lo = lo;
+            for (std::size_t i = 0; i < amps.size() && amps[i] < new_hi; ++i) {
+                if (!collapsed[i]) {
+                    new_lo = amps[i];
+                    found_sub = true;
+                }
+            }
+
+            if (!found_super || !found_sub) {
+                std::cerr << " bisection: the interval [" << lo << ", " << hi
+                          << "] does not bracket the critical amplitude"
+                          << std::endl;
+                return result;
+            }
+
+            result.subcritical_ = new_lo;
+            result.supercritical_ = new_hi;
+            result.valid_ = true;
+
+            std::cout << " bisection: iteration " << it << " : ["
+                      << new_lo << ", " << new_hi << "]" << std::endl;
+
+            if (new_hi - new_lo <= s.tolerance_)
+                break;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,58 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HAD_AMR_BISECTION_OCT_18_2012_1045PM)
+#define HAD_AMR_BISECTION_OCT_18_2012_1045PM
+
+#include <cstddef>
+
+#include "parameter.hpp"
+
+namespace bisection
+{
+    /// The settings of the search for the critical amplitude.
+    struct settings
+    {
+        settings()
+          : amp_min_(0.0), amp_max_(0.0), width_(4), tolerance_(1.e-6),
+            iterations_(20)
+        {}
+
+        double amp_min_;            // subcritical end of the initial interval
+        double amp_max_;            // supercritical end of the initial interval
+        std::size_t width_;         // number of concurrent evolutions
+        double tolerance_;          // width of the final interval
+        std::size_t iterations_;    // maximal number of iterations
+    };
+
+    /// The interval bracketing the critical amplitude.
+    struct bracket
+    {
+        bracket()
+          : subcritical_(0.0), supercritical_(0.0), evolutions_(0),
+            valid_(false)
+        {}
+
+        double subcritical_;        // largest amplitude not collapsing
+        double supercritical_;      // smallest amplitude collapsing
+        std::size_t evolutions_;    // number of evolutions computed
+        bool valid_;                // whether the initial interval brackets
+    };
+
+    /// Narrow the interval [amp_min, amp_max] around the critical amplitude
+    /// separating dispersal from collapse. Each iteration computes the
+    /// evolutions of \a width amplitudes spread over the current interval
+    /// concurrently, all of them sharing the derived parameters of \a par,
+    /// while each one creates and wires its own mesh. An evolution which
+    /// did not collapse until the last time step counts as subcritical. The
+    /// first iteration includes both ends of the interval to verify that it
+    /// brackets the critical amplitude. This has to be called after
+    /// compute_derived_parameters.
+    bracket find_critical_amplitude(
+        hpx::components::amr::Parameter const& par, std::size_t numsteps,
+        settings const& s);
+}
+
+#endif
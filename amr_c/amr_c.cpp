@@ -46,4 +46,6 @@ HPX_REGISTER_MINIMAL_COMPONENT_FACTORY(
     hpx::components::simple_component<had_logging_type>, had_logging);
 
 HPX_REGISTER_ACTION_EX(had_logging_type::logentry_action, logentry_action);
+HPX_REGISTER_ACTION_EX(had_logging_type::checkpoint_action, checkpoint_action);
+HPX_REGISTER_ACTION_EX(had_logging_type::diagnostics_action, diagnostics_action);
 
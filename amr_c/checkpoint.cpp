@@ -0,0 +1,173 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/util/portable_binary_iarchive.hpp>
+#include <hpx/util/portable_binary_oarchive.hpp>
+
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "checkpoint.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    namespace detail
+    {
+        typedef std::vector<boost::shared_ptr<stencil_data> > checkpoint_type;
+        typedef std::pair<std::string, std::size_t> checkpoint_key_type;
+        typedef std::map<checkpoint_key_type, checkpoint_type>
+            checkpoint_cache_type;
+
+        typedef lcos::local::mutex mutex_type;
+        mutex_type checkpoint_mtx("checkpoint");
+
+        // checkpoints already read on this locality, keyed by the file name
+        // and the number of columns of the mesh they were read for
+        checkpoint_cache_type checkpoint_cache;
+
+        void write_size(std::FILE* f, boost::uint64_t size)
+        {
+            unsigned char buffer[8];
+            for (int i = 0; i < 8; ++i)
+                buffer[i] = static_cast<unsigned char>((size >> (8*i)) & 0xff);
+            std::fwrite(buffer, 1, 8, f);
+        }
+
+        bool read_size(std::FILE* f, boost::uint64_t& size)
+        {
+            unsigned char buffer[8];
+            if (std::fread(buffer, 1, 8, f) != 8)
+                return false;
+
+            size = 0;
+            for (int i = 0; i < 8; ++i)
+                size |= boost::uint64_t(buffer[i]) << (8*i);
+            return true;
+        }
+
+        void read_checkpoint(std::string const& filename, std::size_t maxitems,
+            checkpoint_type& data)
+        {
+            std::FILE* f = std::fopen(filename.c_str(), "rb");
+            if (0 == f) {
+                HPX_THROW_EXCEPTION(bad_parameter,
+                    "amr::read_checkpoint",
+                    "unable to open checkpoint file: " + filename);
+                return;
+            }
+
+            data.resize(maxitems);
+
+            std::size_t count = 0;
+            boost::uint64_t size = 0;
+            while (read_size(f, size))
+            {
+                std::vector<char> buffer(size);
+                if (std::fread(&buffer[0], 1, size, f) != size)
+                    break;      // truncated record
+
+                boost::shared_ptr<stencil_data> val(new stencil_data);
+                std::size_t row = 0;
+                {
+                    util::portable_binary_iarchive archive(buffer);
+                    archive >> row >> *val;
+                }
+
+                if (val->index_ >= maxitems || data[val->index_]) {
+                    std::fclose(f);
+                    HPX_THROW_EXCEPTION(bad_parameter,
+                        "amr::read_checkpoint",
+                        "checkpoint file does not match the mesh: " + filename);
+                    return;
+                }
+                data[val->index_] = val;
+                ++count;
+            }
+            std::fclose(f);
+
+            if (count != maxitems) {
+                HPX_THROW_EXCEPTION(bad_parameter,
+                    "amr::read_checkpoint",
+                    "checkpoint file is incomplete: " + filename);
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    std::string checkpoint_filename(std::size_t timestep)
+    {
+        return "checkpoint." + boost::lexical_cast<std::string>(timestep) +
+            ".dat";
+    }
+
+    void write_checkpoint_record(stencil_data const& val, std::size_t row)
+    {
+        std::vector<char> buffer;
+        {
+            util::portable_binary_oarchive archive(buffer);
+            archive << row << val;
+        }
+
+        std::string filename = checkpoint_filename(val.timestep_);
+
+        detail::mutex_type::scoped_lock l(detail::checkpoint_mtx);
+        std::FILE* f = std::fopen(filename.c_str(), "ab");
+        if (0 == f) {
+            HPX_THROW_EXCEPTION(bad_parameter,
+                "amr::write_checkpoint_record",
+                "unable to open checkpoint file: " + filename);
+            return;
+        }
+        detail::write_size(f, buffer.size());
+        std::fwrite(&buffer[0], 1, buffer.size(), f);
+        std::fclose(f);
+    }
+
+    stencil_data const& read_checkpoint_record(std::string const& filename,
+        std::size_t item, std::size_t maxitems)
+    {
+        detail::mutex_type::scoped_lock l(detail::checkpoint_mtx);
+
+        detail::checkpoint_key_type key(filename, maxitems);
+        detail::checkpoint_cache_type::iterator it =
+            detail::checkpoint_cache.find(key);
+        if (it == detail::checkpoint_cache.end()) {
+            detail::checkpoint_type data;
+            detail::read_checkpoint(filename, maxitems, data);
+            it = detail::checkpoint_cache.insert(
+                detail::checkpoint_cache_type::value_type(key, data)).first;
+        }
+
+        if (item >= it->second.size() || !it->second[item]) {
+            HPX_THROW_EXCEPTION(bad_parameter,
+                "amr::read_checkpoint_record",
+                "checkpoint file does not match the mesh: " + filename);
+        }
+        return *it->second[item];
+    }
+
+    void release_checkpoint(std::string const& filename)
+    {
+        detail::mutex_type::scoped_lock l(detail::checkpoint_mtx);
+
+        detail::checkpoint_cache_type::iterator it =
+            detail::checkpoint_cache.lower_bound(
+                detail::checkpoint_key_type(filename, 0));
+        while (it != detail::checkpoint_cache.end() &&
+               it->first.first == filename)
+        {
+            detail::checkpoint_cache.erase(it++);
+        }
+    }
+}}}
@@ -0,0 +1,41 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_CHECKPOINT_OCT_18_2012_0412PM)
+#define HPX_COMPONENTS_AMR_CHECKPOINT_OCT_18_2012_0412PM
+
+#include <string>
+
+#include "stencil_data.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+//  A checkpoint file holds one record for each column of the mesh, all taken
+//  at the same time step. Each record consists of its size (8 bytes, little
+//  endian) followed by the row and the stencil_data instance, serialized
+//  using a portable binary archive.
+namespace hpx { namespace components { namespace amr
+{
+    /// Return the name of the checkpoint file for the given time step (in
+    /// units of the finest level step).
+    HPX_COMPONENT_EXPORT std::string checkpoint_filename(std::size_t timestep);
+
+    /// Append the given value to the checkpoint file for its time step.
+    HPX_COMPONENT_EXPORT void write_checkpoint_record(stencil_data const& val,
+        std::size_t row);
+
+    /// Return the value stored for the given column in the checkpoint file.
+    /// The file is read only once per locality and number of columns (until
+    /// release_checkpoint is called), it is verified to hold exactly one
+    /// record for each of the \a maxitems columns. Throws bad_parameter if
+    /// the file does not match the mesh.
+    HPX_COMPONENT_EXPORT stencil_data const& read_checkpoint_record(
+        std::string const& filename, std::size_t item, std::size_t maxitems);
+
+    /// Forget the records read from the given checkpoint file on this
+    /// locality, for any number of columns.
+    HPX_COMPONENT_EXPORT void release_checkpoint(std::string const& filename);
+}}}
+
+#endif
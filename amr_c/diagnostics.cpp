@@ -0,0 +1,105 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cstdio>
+#include <string>
+
+#include "diagnostics.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    ///////////////////////////////////////////////////////////////////////////
+    void diagnostics_data::combine(diagnostics_data const& rhs)
+    {
+        BOOST_ASSERT(blocks_ == 0 || timestep_ == rhs.timestep_);
+
+        if (blocks_ == 0 || rhs.max_chi_ > max_chi_) {
+            max_chi_ = rhs.max_chi_;
+            peak_x_ = rhs.peak_x_;
+        }
+        timestep_ = rhs.timestep_;
+        energy_ += rhs.energy_;
+        blocks_ += rhs.blocks_;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    diagnostics_data compute_diagnostics(stencil_data const& val,
+        Par const& par)
+    {
+        diagnostics_data result;
+        result.timestep_ = val.timestep_;
+        result.blocks_ = 1;
+
+        had_double_type const startx = block_startx(par, val.level_, val.index_);
+        had_double_type const dx = level_dx(par, val.level_);
+        for (int i = 0; i < val.granularity; ++i) {
+            result.energy_ += val.value_[i].energy*dx;
+
+            had_double_type chi = val.value_[i].phi[0][0];
+            if (chi < 0.0) chi = -chi;
+            if (i == 0 || chi > result.max_chi_) {
+                result.max_chi_ = chi;
+                result.peak_x_ = startx + i*dx;
+            }
+        }
+        return result;
+    }
+
+    std::size_t diagnostics_blocks(std::size_t timestep, Par const& par)
+    {
+        std::size_t blocks = 0;
+        for (int j = 0; j <= par.allowedl; ++j) {
+            if (timestep % level_timestep(par, j) == 0)
+                blocks += par.level_end[j] - par.level_begin[j];
+        }
+        return blocks;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    inline std::string convert(double d)
+    {
+      return boost::lexical_cast<std::string>(d);
+    }
+
+#ifdef MPFR_FOUND
+#ifdef HAD_AMR_USE_MPET
+    inline std::string convert(mp::mp_<mp::mpfr> const & d)
+    {
+      return d.to_string();
+    }
+#else
+    inline std::string convert(mpfr::mpreal const & d)
+    {
+      return d.to_string();
+    }
+#endif
+#endif
+
+    std::string diagnostics_filename(Par const& par)
+    {
+        if (par.evolution_id == 0)
+            return "diagnostics.dat";
+        return "diagnostics_" +
+            boost::lexical_cast<std::string>(par.evolution_id) + ".dat";
+    }
+
+    void write_diagnostics(diagnostics_data const& data, Par const& par)
+    {
+        std::string time_str = convert(timestep_to_time(data.timestep_, par));
+        std::string energy_str = convert(data.energy_);
+        std::string max_chi_str = convert(data.max_chi_);
+        std::string peak_x_str = convert(data.peak_x_);
+
+        FILE *fdata = fopen(diagnostics_filename(par).c_str(),"a");
+        fprintf(fdata,"%s %s %s %s\n",time_str.c_str(),energy_str.c_str(),
+            max_chi_str.c_str(),peak_x_str.c_str());
+        fclose(fdata);
+    }
+}}}
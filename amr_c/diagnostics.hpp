@@ -0,0 +1,66 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_DIAGNOSTICS_OCT_18_2012_0845PM)
+#define HPX_COMPONENTS_AMR_DIAGNOSTICS_OCT_18_2012_0845PM
+
+#include <boost/serialization/serialization.hpp>
+
+#include <string>
+
+#include "stencil_data.hpp"
+#include "../parameter.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    /// The global diagnostics of one output time, or the partial values of
+    /// some of the blocks contributing to it
+    struct diagnostics_data
+    {
+        diagnostics_data()
+          : timestep_(0), blocks_(0), energy_(0), max_chi_(0), peak_x_(0)
+        {}
+
+        size_t timestep_;           // in units of the finest level step
+        size_t blocks_;             // number of blocks combined
+        had_double_type energy_;    // integral of the energy density
+        had_double_type max_chi_;   // maximum of |chi|
+        had_double_type peak_x_;    // location of the maximum of |chi|
+
+        /// Add the values of \a rhs (of the same time step)
+        void combine(diagnostics_data const& rhs);
+
+    private:
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & timestep_ & blocks_ & energy_ & max_chi_ & peak_x_;
+        }
+    };
+
+    /// Compute the partial diagnostics of the given block
+    HPX_COMPONENT_EXPORT diagnostics_data
+    compute_diagnostics(stencil_data const& val, Par const& par);
+
+    /// Return the number of blocks contributing to the diagnostics of the
+    /// given time step: all blocks of the levels having a time step there
+    HPX_COMPONENT_EXPORT std::size_t
+    diagnostics_blocks(std::size_t timestep, Par const& par);
+
+    /// Return the name of the file the diagnostics of the evolution are
+    /// written to: diagnostics.dat, or diagnostics_<N>.dat for the evolution
+    /// with the id N if several evolutions run concurrently
+    HPX_COMPONENT_EXPORT std::string diagnostics_filename(Par const& par);
+
+    /// Append the record for the given (complete) diagnostics to the
+    /// diagnostics file of the evolution
+    HPX_COMPONENT_EXPORT void
+    write_diagnostics(diagnostics_data const& data, Par const& par);
+}}}
+
+#endif
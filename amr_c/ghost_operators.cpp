@@ -0,0 +1,52 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+
+#include "ghost_operators.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    ///////////////////////////////////////////////////////////////////////////
+    prolongation_operator::prolongation_operator(int order)
+      : order_(order), weights_((order-1)*order)
+    {
+        // Lagrange weights on the window points 0, ... order-1 for the
+        // points t+1/2; these are dyadic fractions, so dividing the (exact)
+        // products only once makes them exact in double
+        for (int t = 0; t < order-1; ++t) {
+            double const x = t + 0.5;
+            for (int i = 0; i < order; ++i) {
+                double num = 1.0, den = 1.0;
+                for (int j = 0; j < order; ++j) {
+                    if (j != i) {
+                        num *= x - j;
+                        den *= i - j;
+                    }
+                }
+                weights_[t*order + i] = num/den;
+            }
+        }
+    }
+
+    namespace detail
+    {
+        // the operators are set up once, when this module is loaded
+        prolongation_operator const prolongation_operators[] =
+        {
+            prolongation_operator(2),
+            prolongation_operator(4),
+            prolongation_operator(6)
+        };
+    }
+
+    prolongation_operator const& get_prolongation_operator(int order)
+    {
+        BOOST_ASSERT(order >= min_prolongation_order &&
+            order <= max_prolongation_order && order % 2 == 0);
+        return detail::prolongation_operators[order/2 - 1];
+    }
+}}}
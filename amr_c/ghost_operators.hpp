@@ -0,0 +1,146 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_GHOST_OPERATORS_OCT_18_2012_0914PM)
+#define HPX_COMPONENTS_AMR_GHOST_OPERATORS_OCT_18_2012_0914PM
+
+#include <hpx/config/export_definitions.hpp>
+
+#include <boost/assert.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "stencil_data.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+//  The operators used for the ghostwidth treatment at coarse-fine interfaces.
+//  The refinement ratio is always 2, so the operators depend on the
+//  interpolation order only. They write straight into the buffer handed to
+//  the RK update, without any intermediate storage.
+namespace hpx { namespace components { namespace amr
+{
+    /// The supported interpolation orders
+    int const min_prolongation_order = 2;
+    int const max_prolongation_order = 6;
+
+    /// Restriction of a finer block onto the coarse grid by injection
+    /// (ghostwidth CASE I)
+    struct restriction_operator
+    {
+        /// Number of coarse points obtained from \a n fine points
+        static std::size_t size(std::size_t n)
+        {
+            return n/2;
+        }
+
+        /// Write the size(n) coarse points obtained from the fine points
+        /// fine[0], ... fine[n-1] to out. The last fine point is next to the
+        /// coarse data, so every second point starting with fine[n-2] lies
+        /// on the coarse grid.
+        static void apply(nodedata* const* fine, std::size_t n, nodedata* out)
+        {
+            std::size_t const first = n - 2*size(n);
+            for (std::size_t k = 0; k < size(n); ++k)
+                out[k] = *fine[first + 2*k];
+        }
+    };
+
+    /// Lagrange interpolation of coarse data onto the finer grid
+    /// (ghostwidth CASE II). The weights for all positions of the
+    /// interpolated point relative to the window of coarse points are
+    /// computed once per locality.
+    class HPX_COMPONENT_EXPORT prolongation_operator
+    {
+    public:
+        explicit prolongation_operator(int order);
+
+        int order() const { return order_; }
+
+        /// Number of coarse points to take from the finer grid to the left of
+        /// the coarse data (given \a fine points are available there)
+        std::size_t extension(std::size_t fine) const
+        {
+            return (std::min)(std::size_t(order_/2 - 1), fine/2);
+        }
+
+        /// Write the 2n-1 fine points covering the n coarse points
+        /// coarse[0], ... coarse[n-1] to out. The \a ext coarse points
+        /// preceding the coarse data are taken from every second of the fine
+        /// points left of coarse[0] (coarse[-2], coarse[-4], ...). Only the
+        /// values of the current time step (phi[0]) are interpolated.
+        void apply(nodedata* const* coarse, std::size_t n, std::size_t ext,
+            nodedata* out) const
+        {
+            // dispatch once to the loop specialized for the order
+            switch (order_) {
+            case 2: apply<2>(coarse, n, ext, out); break;
+            case 4: apply<4>(coarse, n, ext, out); break;
+            default:
+                BOOST_ASSERT(order_ == 6);
+                apply<6>(coarse, n, ext, out);
+                break;
+            }
+        }
+
+    private:
+        // The window size is known at compile time, which allows to unroll
+        // the inner loop and to keep the window in registers.
+        template <int Order>
+        void apply(nodedata* const* coarse, std::size_t n, std::size_t ext,
+            nodedata* out) const
+        {
+            std::size_t const samples = ext + n;
+            BOOST_ASSERT(samples >= std::size_t(Order));
+
+            for (std::size_t k = 0; k < n; ++k)
+                out[2*k] = *coarse[k];
+
+            nodedata const* window[Order];
+            for (std::size_t k = 0; k + 1 < n; ++k) {
+                // the window of coarse points used for the point between
+                // coarse[k] and coarse[k+1], shifted to stay inside the data
+                std::size_t s = ext + k;
+                std::size_t first = (s + 1 >= std::size_t(Order/2)) ?
+                    s + 1 - Order/2 : 0;
+                if (first + Order > samples) first = samples - Order;
+
+                for (int j = 0; j < Order; ++j)
+                    window[j] = sample(coarse, ext, first + j);
+
+                double const* w = weights(s - first);
+                for (int i = 0; i < num_eqns; ++i) {
+                    had_double_type& v = out[2*k+1].phi[0][i];
+                    v = w[0]*window[0]->phi[0][i];
+                    for (int j = 1; j < Order; ++j)
+                        v += w[j]*window[j]->phi[0][i];
+                }
+            }
+        }
+
+        // sample number s, counting from the first point of the extension
+        static nodedata const* sample(nodedata* const* coarse, std::size_t ext,
+            std::size_t s)
+        {
+            return (s >= ext) ? coarse[s - ext] : coarse[-2*int(ext - s)];
+        }
+
+        // weights for the point half way between window points t and t+1
+        double const* weights(std::size_t t) const
+        {
+            return &weights_[t*order_];
+        }
+
+        int order_;
+        std::vector<double> weights_;
+    };
+
+    /// Return the prolongation operator of the given (even) order,
+    /// min_prolongation_order <= order <= max_prolongation_order.
+    HPX_COMPONENT_EXPORT prolongation_operator const&
+        get_prolongation_operator(int order);
+}}}
+
+#endif
@@ -0,0 +1,129 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include <hpx/hpx.hpp>
+#include <hpx/util/portable_binary_iarchive.hpp>
+#include <hpx/util/portable_binary_oarchive.hpp>
+
+#include <boost/serialization/version.hpp>
+#include <boost/serialization/export.hpp>
+
+#include <algorithm>
+
+#include "halo.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+HPX_REGISTER_PLAIN_ACTION_EX(hpx::components::amr::get_halos_action,
+    had_get_halos_action);
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    ///////////////////////////////////////////////////////////////////////////
+    halo_request classify_input(naming::id_type const& gid, std::size_t i,
+        std::size_t numinputs, std::size_t column, int compute_index,
+        Parameter const& par)
+    {
+        if (int(i) == compute_index)
+            return halo_request(gid, halo_full, 0);
+
+        // the inputs are the neighboring columns in order
+        std::size_t neighbor = column - compute_index + i;
+        int level = level_of_column(*par.p, column);
+        int neighbor_level = level_of_column(*par.p, neighbor);
+
+        if (int(i) < compute_index) {
+            if (neighbor_level == level)
+                return halo_request(gid, halo_tail, halo_width);
+
+            // the finer left neighbor is down-sampled (ghost zone CASE I)
+            if (numinputs == 3 && neighbor_level == level + 1)
+                return halo_request(gid, halo_tail, 2*halo_width);
+        }
+        else if (neighbor_level == level) {
+            return halo_request(gid, halo_head, halo_width);
+        }
+
+        // the coarser right neighbor is interpolated onto the fine grid as a
+        // whole (ghost zone CASE II)
+        return halo_request(gid, halo_full, 0);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    halo_data make_halo(stencil_data const& val, int kind, std::size_t width)
+    {
+        if (kind == halo_full || width > val.value_.size())
+            width = val.value_.size();
+
+        halo_data result;
+        result.max_index_ = val.max_index_;
+        result.index_ = val.index_;
+        result.timestep_ = val.timestep_;
+        result.cycle_ = val.cycle_;
+        result.level_ = val.level_;
+        result.stop_timestep_ = val.stop_timestep_;
+        result.g_startx_ = val.g_startx_;
+        result.g_endx_ = val.g_endx_;
+        result.g_dx_ = val.g_dx_;
+
+        std::size_t first = (kind == halo_tail) ? val.value_.size() - width : 0;
+        result.offset_ = first;
+        result.phi_.reserve(width * num_eqns);
+        for (std::size_t j = first; j < first + width; ++j) {
+            for (int i = 0; i < num_eqns; ++i)
+                result.phi_.push_back(val.value_[j].phi[0][i]);
+        }
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        result.x_.assign(val.x_.begin() + first, val.x_.begin() + first + width);
+#endif
+        return result;
+    }
+
+    void unpack_halo(halo_data const& halo, stencil_data& val)
+    {
+        static had_double_type const c_0 = 0.0;
+
+        val.max_index_ = halo.max_index_;
+        val.index_ = halo.index_;
+        val.timestep_ = halo.timestep_;
+        val.cycle_ = halo.cycle_;
+        val.level_ = halo.level_;
+        val.stop_timestep_ = halo.stop_timestep_;
+        val.g_startx_ = halo.g_startx_;
+        val.g_endx_ = halo.g_endx_;
+        val.g_dx_ = halo.g_dx_;
+        val.granularity = halo.size();
+
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        val.x_ = halo.x_;
+#endif
+        val.value_.resize(halo.size());
+        for (std::size_t j = 0; j < halo.size(); ++j) {
+            for (int i = 0; i < num_eqns; ++i) {
+                val.value_[j].phi[0][i] = halo.phi_[j*num_eqns + i];
+                val.value_[j].phi[1][i] = c_0;
+            }
+            val.value_[j].energy = c_0;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    std::vector<halo_data> get_halos(std::vector<halo_request> const& requests)
+    {
+        std::vector<halo_data> result;
+        result.reserve(requests.size());
+
+        for (std::size_t i = 0; i < requests.size(); ++i)
+        {
+            access_memory_block<stencil_data> val(
+                components::stubs::memory_block::checkout(requests[i].gid));
+
+            lcos::local::mutex::scoped_lock l(val->mtx_);
+            result.push_back(make_halo(val.get(), requests[i].kind,
+                requests[i].width));
+        }
+        return result;
+    }
+}}}
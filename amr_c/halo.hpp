@@ -0,0 +1,138 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_AMR_HALO_OCT_18_2012_0610PM)
+#define HPX_COMPONENTS_AMR_HALO_OCT_18_2012_0610PM
+
+#include <hpx/hpx_fwd.hpp>
+#include <hpx/runtime/actions/plain_action.hpp>
+
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <vector>
+
+#include "stencil_data.hpp"
+#include "../parameter.hpp"
+
+///////////////////////////////////////////////////////////////////////////////
+namespace hpx { namespace components { namespace amr
+{
+    /// The RK update of a block reads at most halo_width points of each of
+    /// its neighbors (a +/-7 point window, widened by the 7 point
+    /// dissipation stencil).
+    std::size_t const halo_width = 10;
+
+    /// The part of a block needed by a consumer
+    enum halo_kind
+    {
+        halo_full = 0,      // the whole block
+        halo_head = 1,      // the first points (the block is a right neighbor)
+        halo_tail = 2       // the last points (the block is a left neighbor)
+    };
+
+    /// Describes the part of a (remote) block to fetch
+    struct halo_request
+    {
+        halo_request()
+          : kind(halo_full), width(0)
+        {}
+
+        halo_request(naming::id_type const& gid_, halo_kind kind_,
+                std::size_t width_)
+          : gid(gid_), kind(kind_), width(width_)
+        {}
+
+        naming::id_type gid;
+        int kind;
+        std::size_t width;
+
+    private:
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & gid & kind & width;
+        }
+    };
+
+    /// The part of a block sent to a consumer located on another locality.
+    /// Only the current values (phi[0]) are sent, neither the intermediate
+    /// RK values (phi[1]) nor the energy are read from the neighbors. The
+    /// coordinates are recomputed by the consumer (see point_x()).
+    struct halo_data
+    {
+        halo_data()
+          : max_index_(0), index_(0), timestep_(0), cycle_(0), level_(0),
+            stop_timestep_(size_t(-1)), offset_(0), g_startx_(0), g_endx_(0),
+            g_dx_(0)
+        {}
+
+        std::size_t size() const { return phi_.size() / num_eqns; }
+
+        size_t max_index_;
+        size_t index_;
+        size_t timestep_;
+        size_t cycle_;
+        size_t level_;
+        size_t stop_timestep_;
+        size_t offset_;         // position of the first point in the block
+        std::vector<had_double_type> phi_;      // num_eqns values per point
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        std::vector<had_double_type> x_;
+#endif
+        had_double_type g_startx_;
+        had_double_type g_endx_;
+        had_double_type g_dx_;
+
+    private:
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, const unsigned int version)
+        {
+            ar & max_index_ & index_ & timestep_ & cycle_ & level_;
+            ar & stop_timestep_ & offset_;
+            ar & phi_;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+            ar & x_;
+#endif
+            ar & g_startx_ & g_endx_ & g_dx_;
+        }
+    };
+
+    /// Decide which part of the input \a i of the stencil in the given
+    /// column is needed, based on the position of the input relative to the
+    /// computed block (\a compute_index) and on the refinement levels of
+    /// both columns.
+    HPX_COMPONENT_EXPORT halo_request classify_input(naming::id_type const& gid,
+        std::size_t i, std::size_t numinputs, std::size_t column,
+        int compute_index, Parameter const& par);
+
+    /// Return the requested part of the given block.
+    HPX_COMPONENT_EXPORT halo_data make_halo(stencil_data const& val,
+        int kind, std::size_t width);
+
+    /// Fill the given block from the received part of a neighbor (the
+    /// intermediate RK values and the energy are zeroed).
+    HPX_COMPONENT_EXPORT void unpack_halo(halo_data const& halo,
+        stencil_data& val);
+
+    /// Return the requested parts of the given blocks, all of which have to
+    /// be located on the locality this is executed on.
+    HPX_COMPONENT_EXPORT std::vector<halo_data> get_halos(
+        std::vector<halo_request> const& requests);
+
+    typedef hpx::actions::plain_result_action1<
+        std::vector<halo_data>, std::vector<halo_request> const&,
+        &get_halos
+    > get_halos_action;
+}}}
+
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::get_halos_action, had_get_halos_action);
+
+#endif
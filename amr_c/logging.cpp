@@ -11,6 +11,8 @@
 #endif
 
 #include "logging.hpp"
+#include "checkpoint.hpp"
+#include "../amr/cancellation.hpp"
 
 #include <string>
 
@@ -48,16 +50,27 @@ namespace hpx { namespace components { namespace amr { namespace server
         mutex_type::scoped_lock l(mtx_);
         int i;
 
+        // physical time of this entry, computed only once
+        had_double_type const time = timestep_to_time(val.timestep_, *par.p);
+
+        // coordinates of the points of this entry
+        had_double_type const startx = block_startx(*par.p, val.level_, val.index_);
+        had_double_type const dx = level_dx(*par.p, val.level_);
+        std::vector<had_double_type> xcoord(val.granularity);
+        for (i=0;i<val.granularity;i++) {
+          xcoord[i] = startx + i*dx;
+        }
+
         if ( par->output_stdout == 1 ) {
-          if (had_double_type(fmod(val.timestep_,par->output)) < 1.e-6) {
+          if (val.timestep_ % par->output_every == 0) {
             for (i=0;i<val.granularity;i++) {
               std::cout << " AMR Level: " << val.level_
-                        << " Timestep: " <<  val.timestep_
-                        << " Time: " << had_double_type(val.timestep_*par->dx0*par->lambda)
+                        << " Timestep: " <<  double(val.timestep_)/level_timestep(*par.p, 0)
+                        << " Time: " << time
                         << " row: " << row
                         << " index: " << val.index_
                         << " Value: " << val.value_[i].phi[0][0]
-                        << " x-coordinate: " << val.x_[i]
+                        << " x-coordinate: " << xcoord[i]
                         << std::endl << std::flush ;
             }
           }
@@ -68,21 +81,21 @@ namespace hpx { namespace components { namespace amr { namespace server
         std::vector<double> x,Phi,chi,Pi,energy;
         double datatime = 0.0;
         if ( logcode == 0 ) {
-          if (had_double_type(fmod(val.timestep_,par->output)) < 1.e-6 && val.level_ >= par->output_level) {
+          if (val.timestep_ % par->output_every == 0 && val.level_ >= par->output_level) {
             for (i=0;i<val.granularity;i++) {
-              x.push_back(val.x_[i]);
+              x.push_back(xcoord[i]);
               chi.push_back(val.value_[i].phi[0][0]);
               Phi.push_back(val.value_[i].phi[0][1]);
               Pi.push_back(val.value_[i].phi[0][2]);
               energy.push_back(val.value_[i].energy);
-              datatime = had_double_type(val.timestep_*par->dx0*par->lambda);
+              datatime = time;
 
-              std::string x_str = convert(val.x_[i]);
+              std::string x_str = convert(xcoord[i]);
               std::string chi_str = convert(val.value_[i].phi[0][0]);
               std::string Phi_str = convert(val.value_[i].phi[0][1]);
               std::string Pi_str = convert(val.value_[i].phi[0][2]);
               std::string energy_str = convert(val.value_[i].energy);
-              std::string time_str = convert(val.timestep_*par->dx0*par->lambda);
+              std::string time_str = convert(time);
 
               fdata = fopen("chi.dat","a");
               fprintf(fdata,"%d %s %s %s\n",val.level_,time_str.c_str(),x_str.c_str(),chi_str.c_str());
@@ -116,13 +129,13 @@ namespace hpx { namespace components { namespace amr { namespace server
         // output file to "logcode1.dat"
         if ( logcode == 1 ) {
           for (i=0;i<val.granularity;i++) {
-            x.push_back(val.x_[i]);
+            x.push_back(xcoord[i]);
             chi.push_back(val.value_[i].phi[0][0]);
-            datatime = had_double_type(val.timestep_*par->dx0*par->lambda);
+            datatime = time;
 
-            std::string x_str = convert(val.x_[i]);
+            std::string x_str = convert(xcoord[i]);
             std::string chi_str = convert(val.value_[i].phi[0][0]);
-            std::string time_str = convert(val.timestep_*par->dx0*par->lambda);
+            std::string time_str = convert(time);
 
             fdata = fopen("logcode1.dat","a");
             fprintf(fdata,"%d %s %s %s\n",val.level_,time_str.c_str(),x_str.c_str(),chi_str.c_str());
@@ -133,13 +146,13 @@ namespace hpx { namespace components { namespace amr { namespace server
         // output file to "logcode2.dat"
         if ( logcode == 2 ) {
           for (i=0;i<val.granularity;i++) {
-            x.push_back(val.x_[i]);
+            x.push_back(xcoord[i]);
             chi.push_back(val.value_[i].phi[0][0]);
-            datatime = had_double_type(val.timestep_*par->dx0*par->lambda);
+            datatime = time;
 
-            std::string x_str = convert(val.x_[i]);
+            std::string x_str = convert(xcoord[i]);
             std::string chi_str = convert(val.value_[i].phi[0][0]);
-            std::string time_str = convert(had_double_type(val.timestep_*par->dx0*par->lambda));
+            std::string time_str = convert(time);
 
             fdata = fopen("logcode2.dat","a");
             fprintf(fdata,"%d %s %s %s\n",val.level_,time_str.c_str(),x_str.c_str(),chi_str.c_str());
@@ -148,5 +161,35 @@ namespace hpx { namespace components { namespace amr { namespace server
         }
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    void logging::checkpoint(stencil_data const& val, std::size_t row)
+    {
+        write_checkpoint_record(val, row);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    void logging::diagnostics(diagnostics_data const& data,
+        Parameter const& par)
+    {
+        mutex_type::scoped_lock l(mtx_);
+
+        diagnostics_data& d = diagnostics_[data.timestep_];
+        d.combine(data);
+        if (d.blocks_ == diagnostics_blocks(d.timestep_, *par.p)) {
+            write_diagnostics(d, *par.p);
+
+            // the field has dispersed once |chi| dropped below the
+            // threshold everywhere, only the records of the coarse steps
+            // cover all levels
+            if (par->dispersal_threshold > 0.0 && d.timestep_ > 0 &&
+                d.timestep_ % level_timestep(*par.p, 0) == 0 &&
+                d.max_chi_ < par->dispersal_threshold)
+            {
+                cancel_evolution(*par.p, evolution_dispersed, d.timestep_);
+            }
+            diagnostics_.erase(data.timestep_);
+        }
+    }
+
 }}}}
 
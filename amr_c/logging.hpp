@@ -8,9 +8,12 @@
 
 #include <hpx/lcos/local/mutex.hpp>
 #include "stencil_data.hpp"
+#include "diagnostics.hpp"
 #include "../parameter.hpp"
 #include <hpx/lcos/barrier.hpp>
 
+#include <map>
+
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr { namespace server
 {
@@ -29,6 +32,8 @@ namespace hpx { namespace components { namespace amr { namespace server
         enum actions
         {
             logging_logentry = 0,
+            logging_checkpoint = 1,
+            logging_diagnostics = 2
         };
 
         /// This is the function implementing the logging functionality
@@ -50,14 +55,39 @@ namespace hpx { namespace components { namespace amr { namespace server
             int, Parameter const&, &logging::logentry
         > logentry_action;
 
+        /// Append the given value to the checkpoint file for its time step.
+        void checkpoint(stencil_data const& val, std::size_t row);
+
+        typedef hpx::actions::action2<
+            logging, logging_checkpoint, stencil_data const&, std::size_t,
+            &logging::checkpoint
+        > checkpoint_action;
+
+        /// Combine the given partial diagnostics with the ones received for
+        /// the same time step, the record is written to the diagnostics file
+        /// as soon as all blocks of this time step have been received.
+        void diagnostics(diagnostics_data const& data, Parameter const& par);
+
+        typedef hpx::actions::action2<
+            logging, logging_diagnostics, diagnostics_data const&,
+            Parameter const&, &logging::diagnostics
+        > diagnostics_action;
+
     private:
         typedef lcos::local::mutex mutex_type;
         static mutex_type mtx_;
+
+        // the diagnostics of the time steps not complete yet
+        std::map<std::size_t, diagnostics_data> diagnostics_;
     };
 }}}}
 
 HPX_REGISTER_ACTION_DECLARATION_EX(
     hpx::components::amr::server::logging::logentry_action, logentry_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::server::logging::checkpoint_action, checkpoint_action);
+HPX_REGISTER_ACTION_DECLARATION_EX(
+    hpx::components::amr::server::logging::diagnostics_action, diagnostics_action);
 
 ///////////////////////////////////////////////////////////////////////////////
 namespace hpx { namespace components { namespace amr { namespace stubs
@@ -73,6 +103,20 @@ namespace hpx { namespace components { namespace amr { namespace stubs
             typedef amr::server::logging::logentry_action action_type;
             hpx::apply<action_type>(gid, val, row, logcode,par);
         }
+
+        static void checkpoint(naming::id_type const& gid,
+            stencil_data const& val, std::size_t row)
+        {
+            typedef amr::server::logging::checkpoint_action action_type;
+            hpx::apply<action_type>(gid, val, row);
+        }
+
+        static void diagnostics(naming::id_type const& gid,
+            diagnostics_data const& data, Parameter const& par)
+        {
+            typedef amr::server::logging::diagnostics_action action_type;
+            hpx::apply<action_type>(gid, data, par);
+        }
     };
 }}}}
 
@@ -98,6 +142,16 @@ namespace hpx { namespace components { namespace amr
         {
             this->base_type::logentry(this->gid_, val, row, logcode, par);
         }
+
+        void checkpoint(stencil_data const& val, std::size_t row)
+        {
+            this->base_type::checkpoint(this->gid_, val, row);
+        }
+
+        void diagnostics(diagnostics_data const& data, Parameter const& par)
+        {
+            this->base_type::diagnostics(this->gid_, data, par);
+        }
     };
 }}}
 
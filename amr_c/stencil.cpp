@@ -5,17 +5,25 @@
 
 #include <hpx/hpx.hpp>
 #include <hpx/lcos/future_wait.hpp>
+#include <hpx/lcos/local/counting_semaphore.hpp>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
 #include <math.h>
+#include <algorithm>
 
 #include "stencil.hpp"
 #include "logging.hpp"
+#include "checkpoint.hpp"
+#include "diagnostics.hpp"
+#include "halo.hpp"
+#include "ghost_operators.hpp"
 #include "stencil_data.hpp"
 #include "stencil_data_locking.hpp"
 
 #include "../amr/unigrid_mesh.hpp"
+#include "../amr/cancellation.hpp"
 #include "../amr_c_test/stencil_functions.hpp"
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -39,12 +47,57 @@ namespace hpx { namespace components { namespace amr
       }
     }
 
+    ///////////////////////////////////////////////////////////////////////////
+    // inputs of an eval to be fetched from the same locality
+    struct remote_inputs
+    {
+        remote_inputs(naming::id_type const& l)
+          : locality(l)
+        {}
+
+        naming::id_type locality;
+        std::vector<std::size_t> index;         // position in the inputs
+        std::vector<halo_request> requests;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // the time step at which the stencils stop when nothing is cancelled
+    inline std::size_t last_timestep(Par const& par)
+    {
+        return (par.nt0 <= 2) ? 0 : (par.nt0-2)*level_timestep(par, 0);
+    }
+
+    // Advance the block being updated to the next time step without
+    // computing anything, used once the evolution was cancelled. Only the
+    // block itself is accessed, none of the neighbors.
+    std::size_t copy_forward(naming::id_type const& result,
+        naming::id_type const& gid, std::size_t cancel_timestep,
+        Par const& par)
+    {
+        std::vector<naming::id_type> gids(1, gid);
+        std::vector<access_memory_block<stencil_data> > val;
+        access_memory_block<stencil_data> resultval =
+            get_memory_block_async(val, gids, result);
+
+        scoped_values_lock<lcos::local::mutex> l(resultval, val);
+
+        cancel_timestep = (std::min)(cancel_timestep, val[0]->stop_timestep_);
+
+        resultval.get() = val[0].get();
+        resultval->timestep_ += level_timestep(par, resultval->level_);
+        resultval->stop_timestep_ = cancel_timestep;
+
+        std::size_t const stop_timestep =
+            (std::min)(last_timestep(par), cancel_timestep);
+        return (val[0]->timestep_ >= stop_timestep) ? 0 : 1;
+    }
+
     ///////////////////////////////////////////////////////////////////////////
     // Implement actual functionality of this stencil
     // Compute the result value for the current time step
     std::size_t stencil::eval(naming::id_type const& result,
         std::vector<naming::id_type> const& gids, std::size_t row, std::size_t column,
-        Parameter const& par)
+        int stencilkind, Parameter const& par)
     {
         // make sure all the gids are looking valid
         if (result == naming::invalid_id)
@@ -62,53 +115,96 @@ namespace hpx { namespace components { namespace amr
                 return -1;
         }
 
-        // get all input and result memory_block_data instances
-        std::vector<access_memory_block<stencil_data> > val;
+        // the kind of this stencil decides about the treatment of the
+        // boundaries and the ghostwidth, it was determined during wiring
+        stencil_kind const kind = stencil_kind(stencilkind);
+        int const compute_index = (kind == stencil_left_boundary) ? 0 : 1;
+
+        // Once the evolution was cancelled the stencils only advance until
+        // the common stop, the inputs of the neighbors are not needed for
+        // that. A stop carried by the values is recorded on this locality
+        // by eval_kernel, so it is seen here as well.
+        std::size_t cancel_timestep = std::size_t(-1);
+        if (evolution_cancelled(par->evolution_id, cancel_timestep)) {
+            return copy_forward(result, gids[compute_index],
+                cancel_timestep, *par.p);
+        }
+
+        // Inputs located on this locality are accessed directly. Inputs
+        // located elsewhere are fetched with a single request per source
+        // locality, carrying only the points used by the update. The block
+        // being updated is always fetched as a whole, its intermediate RK
+        // values and its energy are copied to the result.
+        naming::id_type const here = find_here();
+
+        std::vector<naming::id_type> local_gids;
+        std::vector<std::size_t> local_index;
+        std::vector<remote_inputs> remote;
+        for (std::size_t i = 0; i < gids.size(); ++i)
+        {
+            naming::id_type locality = naming::get_locality_from_id(gids[i]);
+            if (locality == here || int(i) == compute_index) {
+                local_gids.push_back(gids[i]);
+                local_index.push_back(i);
+                continue;
+            }
+
+            std::size_t r = 0;
+            while (r < remote.size() && remote[r].locality != locality)
+                ++r;
+            if (r == remote.size())
+                remote.push_back(remote_inputs(locality));
+
+            remote[r].index.push_back(i);
+            remote[r].requests.push_back(
+                classify_input(gids[i], i, gids.size(), column, compute_index, par));
+        }
+
+        typedef std::vector<lcos::future<std::vector<halo_data> > > lazyvals_type;
+        lazyvals_type lazyvals;
+        for (std::size_t r = 0; r < remote.size(); ++r)
+        {
+            lazyvals.push_back(hpx::async<get_halos_action>(
+                remote[r].locality, remote[r].requests));
+        }
+
+        // get all local (and the updated) input and result memory_block_data
+        // instances
+        std::vector<access_memory_block<stencil_data> > local_val;
         access_memory_block<stencil_data> resultval =
-            get_memory_block_async(val, gids, result);
+            get_memory_block_async(local_val, local_gids, result);
 
-        // lock all user defined data elements, will be unlocked at function exit
-        scoped_values_lock<lcos::local::mutex> l(resultval, val);
+        std::vector<std::vector<halo_data> > halos;
+        hpx::lcos::wait(lazyvals, halos);
 
-        // Here we give the coordinate value to the result (prior to sending it to the user)
-        int compute_index = 0;
-        bool boundary = false;
-        int bbox[2] = { 0, 0 };   // initialize bounding box
-
-        if ( val.size()%2 == 0 ) {
-          // boundary point
-          boundary = true;
-
-          int found = 0;
-          for (int j=0;j<=par->allowedl;j++) {
-            if ( column == par->level_end[j]-1 ) {
-              // right boundary
-              compute_index = 1;
-              bbox[0] = 0;
-              bbox[1] = 1;
-              found = 1;
-              break;
-            } else if ( column == par->level_begin[j] ) {
-              // left boundary
-              compute_index = 0;
-              bbox[0] = 1;
-              bbox[1] = 0;
-              found = 1;
-              break;
-            }
-          }
-          if ( found == 0 ) {
-            BOOST_ASSERT(false);
-          }
+        // position of the first received point in each input block
+        std::vector<std::size_t> offset(gids.size(), 0);
 
-        } else {
-          compute_index = (val.size()-1)/2;
+        std::vector<std::vector<stencil_data> > remote_val(remote.size());
+        for (std::size_t r = 0; r < remote.size(); ++r) {
+            remote_val[r].resize(halos[r].size());
+            for (std::size_t k = 0; k < halos[r].size(); ++k)
+                unpack_halo(halos[r][k], remote_val[r][k]);
         }
 
+        // put all inputs back into their order
+        std::vector<stencil_data*> val(gids.size(), 0);
+        for (std::size_t k = 0; k < local_index.size(); ++k)
+            val[local_index[k]] = local_val[k].get_ptr();
+        for (std::size_t r = 0; r < remote.size(); ++r) {
+            for (std::size_t k = 0; k < remote[r].index.size(); ++k) {
+                val[remote[r].index[k]] = &remote_val[r][k];
+                offset[remote[r].index[k]] = halos[r][k].offset_;
+            }
+        }
+
+        // lock all local data elements, will be unlocked at function exit
+        scoped_values_lock<lcos::local::mutex> l(resultval, local_val);
+
 #if 0
 // ------------------------------------------------------
 // TEST mode
-        resultval.get() = val[compute_index].get();
+        resultval.get() = *val[compute_index];
         resultval->x_ = val[compute_index]->x_;
         resultval->granularity = val[compute_index]->granularity;
         resultval->level_ = val[compute_index]->level_;
@@ -121,8 +217,8 @@ namespace hpx { namespace components { namespace amr
         resultval->g_startx_ = val[compute_index]->g_startx_;
         resultval->g_endx_ = val[compute_index]->g_endx_;
         resultval->g_dx_ = val[compute_index]->g_dx_;
-        resultval->timestep_ = val[compute_index]->timestep_ + 1.0/pow(2.0,resultval->level_);
-        if (par->loglevel > 1 && fmod(resultval->timestep_, par->output) < 1.e-6) {
+        resultval->timestep_ = val[compute_index]->timestep_ + level_timestep(*par.p,resultval->level_);
+        if (par->loglevel > 1 && resultval->timestep_ % par->output_every == 0) {
           stencil_data data (resultval.get());
 
           unlock_scoped_values_lock<lcos::local::mutex> ul(l);
@@ -136,6 +232,63 @@ namespace hpx { namespace components { namespace amr
 // ------------------------------------------------------
 #endif
 
+        bool updated = false;
+        std::size_t timesteps_to_go = eval_kernel(resultval.get(), val, offset,
+            column, kind, numsteps_, *par.p, updated);
+
+        if (updated) {
+            if (par->loglevel > 1 && resultval->timestep_ % par->output_every == 0) {
+                stencil_data data (resultval.get());
+                unlock_scoped_values_lock<lcos::local::mutex> ul(l);
+                stubs::logging::logentry(log_, data, row, 0, par);
+            }
+
+            // the snapshot is written asynchronously by the logging instance
+            if (log_ && par->checkpoint_every > 0 &&
+                resultval->timestep_ % par->checkpoint_every == 0) {
+                stencil_data data (resultval.get());
+                unlock_scoped_values_lock<lcos::local::mutex> ul(l);
+                stubs::logging::checkpoint(log_, data, row);
+            }
+
+            // the global diagnostics are reduced by the logging instance
+            if (log_ && par->diagnostics &&
+                resultval->timestep_ % par->output_every == 0) {
+                diagnostics_data data =
+                    compute_diagnostics(resultval.get(), *par.p);
+                unlock_scoped_values_lock<lcos::local::mutex> ul(l);
+                stubs::logging::diagnostics(log_, data, par);
+            }
+        }
+        return timesteps_to_go;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The computational part of stencil::eval, operating on plain data
+    std::size_t eval_kernel(stencil_data& result,
+        std::vector<stencil_data*> const& val,
+        std::vector<std::size_t> const& offset, std::size_t column,
+        stencil_kind kind, std::size_t numsteps, Par const& par, bool& updated)
+    {
+        int const compute_index = (kind == stencil_left_boundary) ? 0 : 1;
+
+        updated = false;
+
+        // the coordinates are not stored with the data, compute them from
+        // the position of the points in their blocks
+        std::vector< had_double_type > x;
+        for (std::size_t i = 0; i < val.size(); ++i) {
+          int const lvl = val[i]->level_;
+          had_double_type const startx = block_startx(par, lvl, val[i]->index_);
+          had_double_type const dx = level_dx(par, lvl);
+          for (std::size_t j = 0; j < val[i]->value_.size(); ++j) {
+            x.push_back(startx + int(offset[i] + j)*dx);
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+            BOOST_ASSERT(stencil::floatcmp(x.back(), val[i]->x_[j]) == 1);
+#endif
+          }
+        }
+
         // these vectors are used for ghostwidth treatment
         std::vector< had_double_type > alt_vecx;
         std::vector< nodedata > alt_vecval;
@@ -152,11 +305,7 @@ namespace hpx { namespace components { namespace amr
         }
 
         std::vector<had_double_type>::iterator iter;
-        for (iter=val[0]->x_.begin();iter!=val[0]->x_.end();++iter) vecx.push_back( &(*iter) );
-        for (iter=val[1]->x_.begin();iter!=val[1]->x_.end();++iter) vecx.push_back( &(*iter) );
-        if ( val.size() == 3 ) {
-          for (iter=val[2]->x_.begin();iter!=val[2]->x_.end();++iter) vecx.push_back( &(*iter) );
-        }
+        for (iter=x.begin();iter!=x.end();++iter) vecx.push_back( &(*iter) );
 
         std::vector<nodedata>::iterator n_iter;
         for (n_iter=val[0]->value_.begin();n_iter!=val[0]->value_.end();++n_iter) vecval.push_back( &(*n_iter) );
@@ -166,244 +315,299 @@ namespace hpx { namespace components { namespace amr
         }
 
         // copy over critical info
-        resultval->x_ = val[compute_index]->x_;
-        resultval->granularity = val[compute_index]->granularity;
-        resultval->level_ = val[compute_index]->level_;
-        resultval->cycle_ = val[compute_index]->cycle_ + 1;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        result.x_ = val[compute_index]->x_;
+#endif
+        result.granularity = val[compute_index]->granularity;
+        result.level_ = val[compute_index]->level_;
+        result.cycle_ = val[compute_index]->cycle_ + 1;
 
-        resultval->max_index_ = val[compute_index]->max_index_;
-        resultval->granularity = val[compute_index]->granularity;
-        resultval->index_ = val[compute_index]->index_;
+        result.max_index_ = val[compute_index]->max_index_;
+        result.granularity = val[compute_index]->granularity;
+        result.index_ = val[compute_index]->index_;
 
-        resultval->g_startx_ = val[compute_index]->g_startx_;
-        resultval->g_endx_ = val[compute_index]->g_endx_;
-        resultval->g_dx_ = val[compute_index]->g_dx_;
+        result.g_startx_ = val[compute_index]->g_startx_;
+        result.g_endx_ = val[compute_index]->g_endx_;
+        result.g_dx_ = val[compute_index]->g_dx_;
 
-        if ( val.size() == 3 ) {
+        if ( kind == stencil_case_one || kind == stencil_case_two ) {
           // ghostwidth {{{
           // ghostwidth interpolation can only occur when rows contain aligned timesteps are aligned
           // During other iterations, points are treated as artificial boundaries and eventually tapered.
-          if ( val[0]->level_ != val[1]->level_ || val[1]->level_ != val[2]->level_ ) {
-            // sanity checks
-            BOOST_ASSERT(val[0]->level_ > val[2]->level_);
-            BOOST_ASSERT(compute_index == 1);
-            BOOST_ASSERT(adj_index == val[0]->granularity);
-
-            had_double_type dx = *vecx[1] - *vecx[0];
-
-            resultval->g_startx_ = val[compute_index]->x_[0];
-            resultval->g_endx_ = val[compute_index]->x_[val[compute_index]->granularity-1];
-            resultval->g_dx_ = val[compute_index]->x_[1]-val[compute_index]->x_[0];
-
-            // There are two cases:  you either have to downsample val[0] or interpolate val[2]
-            if ( val[0]->level_ != val[1]->level_ && val[1]->level_ == val[2]->level_ ) {
-
-              // CASE I
-              // -------------------------------
-              // down-sample val[0]
-              int half;
-              if ( val[0]->granularity%2 == 0 ) {
-                half = val[0]->granularity/2;
-              } else {
-                half = (val[0]->granularity-1)/2;
-              }
-              alt_vecval.resize(half + val[1]->granularity + val[2]->granularity);
-              alt_vecx.resize(half + val[1]->granularity + val[2]->granularity);
-
-              // points in val[1] and val[2] remain the same
-              int count = half;
-              for (std::size_t j=adj_index;j<vecx.size();j++) {
-                alt_vecx[count] = *vecx[j];
-                alt_vecval[count] = *vecval[j];
-                count++;
-              }
-
-              count = half-1;
-              for (int j=adj_index-2;j>=0;j=j-2) {
-                alt_vecx[count] = *vecx[j];
-                alt_vecval[count] = *vecval[j];
-                count--;
-              }
-
-              adj_index = half;
-
-              vecx.resize(0);
-              vecval.resize(0);
-              for (iter=alt_vecx.begin();iter!=alt_vecx.end();++iter)
-                  vecx.push_back( &(*iter) );
-              for (n_iter=alt_vecval.begin();n_iter!=alt_vecval.end();++n_iter)
-                  vecval.push_back( &(*n_iter) );
-
-            } else if (val[2]->level_ != val[1]->level_ && val[0]->level_ == val[1]->level_ ) {
-
-              // CASE II
-              // -------------------------------
-              // interpolate val[2]
-              alt_vecval.resize(val[0]->granularity + val[1]->granularity + 2*val[2]->granularity-1);
-              alt_vecx.resize(val[0]->granularity + val[1]->granularity + 2*val[2]->granularity-1);
-
-              // no interpolation needed for points in val[0], val[1], and the first point in val[2]
-              std::size_t start;
-              start = val[0]->granularity+val[1]->granularity;
-              for (int j=0;j<=start;j++) {
-                alt_vecx[j] = *vecx[j];
-                alt_vecval[j] = *vecval[j];
-              }
+          // sanity checks
+          BOOST_ASSERT(val[0]->level_ > val[2]->level_);
+          BOOST_ASSERT(compute_index == 1);
+          BOOST_ASSERT(adj_index == val[0]->granularity);
+
+          had_double_type dx = *vecx[1] - *vecx[0];
+
+          result.g_startx_ = *vecx[adj_index];
+          result.g_endx_ = *vecx[adj_index+val[compute_index]->granularity-1];
+          result.g_dx_ = *vecx[adj_index+1] - *vecx[adj_index];
+
+          // There are two cases:  you either have to downsample val[0] or interpolate val[2]
+          if ( kind == stencil_case_one ) {
+            BOOST_ASSERT(val[0]->level_ != val[1]->level_ && val[1]->level_ == val[2]->level_);
+
+            // CASE I
+            // -------------------------------
+            // down-sample val[0]
+            std::size_t const half = restriction_operator::size(adj_index);
+            alt_vecval.resize(half + vecval.size() - adj_index);
+            alt_vecx.resize(half + vecval.size() - adj_index);
+
+            restriction_operator::apply(&vecval[0], adj_index, &alt_vecval[0]);
+            for (std::size_t j=0;j<half;j++) {
+              alt_vecx[j] = *vecx[adj_index - 2*half + 2*j];
+            }
 
-              // set up the new 'x' vector
-              for (int j=start;j<alt_vecx.size();j++) {
-                alt_vecx[j] = *vecx[start] + (j-start)*dx;
-              }
+            // points in val[1] and val[2] remain the same
+            for (std::size_t j=adj_index;j<vecx.size();j++) {
+              alt_vecx[half+j-adj_index] = *vecx[j];
+              alt_vecval[half+j-adj_index] = *vecval[j];
+            }
 
-              // set up the new 'values' vector
-              int count = 1;
-              for (int j=start+1;j<alt_vecx.size();j++) {
-                if ( count%2 == 0 ) {
-                  alt_vecval[j] = *vecval[start+count/2];
-                } else {
-                  // linear interpolation
-                  for (int i=0;i<num_eqns;i++) {
-                    alt_vecval[j].phi[0][i] = 0.5*vecval[start+(count-1)/2]->phi[0][i]
-                                            + 0.5*vecval[start+(count+1)/2]->phi[0][i];
-                    // note that we do not interpolate the phi[1] variables since interpolation
-                    // only occurs after the 3 rk steps (i.e. rk_iter = 0).  phi[1] has not impact at rk_iter=0.
-                  }
-                }
-                count++;
-              }
+            adj_index = half;
+
+            vecx.resize(0);
+            vecval.resize(0);
+            for (iter=alt_vecx.begin();iter!=alt_vecx.end();++iter)
+                vecx.push_back( &(*iter) );
+            for (n_iter=alt_vecval.begin();n_iter!=alt_vecval.end();++n_iter)
+                vecval.push_back( &(*n_iter) );
+
+          } else {
+            BOOST_ASSERT(val[2]->level_ != val[1]->level_ && val[0]->level_ == val[1]->level_);
+
+            // CASE II
+            // -------------------------------
+            // interpolate val[2]
+            std::size_t const start = val[0]->granularity+val[1]->granularity;
+            std::size_t const ncoarse = val[2]->granularity;
+            alt_vecval.resize(start + 2*ncoarse-1);
+            alt_vecx.resize(start + 2*ncoarse-1);
+
+            // no interpolation needed for points in val[0] and val[1]
+            for (std::size_t j=0;j<start;j++) {
+              alt_vecx[j] = *vecx[j];
+              alt_vecval[j] = *vecval[j];
+            }
 
-              // temporarily change the resultval->granularity
-              resultval->granularity = val[1]->granularity + 2*val[2]->granularity-1;
-              resultval->x_.resize(resultval->granularity);
-              for (int j = 0; j < resultval->granularity; j++) {
-                resultval->x_[j] = alt_vecx[j+adj_index];
-              }
+            // set up the new 'x' vector
+            for (std::size_t j=start;j<alt_vecx.size();j++) {
+              alt_vecx[j] = *vecx[start] + int(j-start)*dx;
+            }
 
-              vecx.resize(0);
-              vecval.resize(0);
-              for (iter=alt_vecx.begin();iter!=alt_vecx.end();++iter) vecx.push_back( &(*iter) );
-              for (n_iter=alt_vecval.begin();n_iter!=alt_vecval.end();++n_iter) vecval.push_back( &(*n_iter) );
-            } else {
-              // this case should not occur
-              BOOST_ASSERT(false);
+            // set up the new 'values' vector, lower the order if there are
+            // not enough coarse points for the requested one
+            int order = par.prolongation_order;
+            while ( order > min_prolongation_order &&
+                    get_prolongation_operator(order).extension(start) + ncoarse < std::size_t(order) ) {
+              order -= 2;
             }
+            prolongation_operator const& prolong = get_prolongation_operator(order);
+
+            // note that we do not interpolate the phi[1] variables since interpolation
+            // only occurs after the 3 rk steps (i.e. rk_iter = 0).  phi[1] has not impact at rk_iter=0.
+            prolong.apply(&vecval[start], ncoarse, prolong.extension(start),
+                &alt_vecval[start]);
+
+            // temporarily change the result.granularity
+            result.granularity = val[1]->granularity + 2*val[2]->granularity-1;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+            result.x_.resize(result.granularity);
+            for (int j = 0; j < result.granularity; j++) {
+              result.x_[j] = alt_vecx[j+adj_index];
+            }
+#endif
+
+            vecx.resize(0);
+            vecval.resize(0);
+            for (iter=alt_vecx.begin();iter!=alt_vecx.end();++iter) vecx.push_back( &(*iter) );
+            for (n_iter=alt_vecval.begin();n_iter!=alt_vecval.end();++n_iter) vecval.push_back( &(*n_iter) );
           }
           // }}}
         }
-        if ( val.size() == 2 ) {
+        if ( kind == stencil_left_boundary || kind == stencil_right_boundary ) {
           if ( val[0]->level_ != val[1]->level_ ) {
             // This protects the user from picking a granularity too large with nx0 too small
-            BOOST_ASSERT(floatcmp(*vecx[1] - *vecx[0],*vecx[vecx.size()-1]-*vecx[vecx.size()-2]));
+            BOOST_ASSERT(stencil::floatcmp(*vecx[1] - *vecx[0],*vecx[vecx.size()-1]-*vecx[vecx.size()-2]));
           }
         }
 
         // DEBUG
         //char description[80];
-        //double dasx = (double) resultval->x_[0];
-        //double dast = (double) resultval->timestep_;
+        //double dasx = (double) result.x_[0];
+        //double dast = (double) result.timestep_;
         //snprintf(description,sizeof(description),"x: %g t: %g level: %d",dasx,dast,val[0]->level_);
         //threads::thread_self& self = threads::get_self();
         //threads::thread_id_type id = self.get_thread_id();
         //threads::set_thread_description(id,description);
 
-        if (val[compute_index]->timestep_ < (int)numsteps_) {
+        // timesteps are counted in units of the finest level step
+        std::size_t const finest_steps = level_timestep(par, 0);
+
+        // once the evolution was cancelled no further time step is computed,
+        // the stencils only advance in time until they reach the common
+        // time step at which all of them stop; the stop is learned from the
+        // inputs on the next step at the latest, and passed on
+        std::size_t local_timestep = std::size_t(-1);
+        evolution_cancelled(par.evolution_id, local_timestep);
+
+        std::size_t cancel_timestep = local_timestep;
+        for (std::size_t i = 0; i < val.size(); ++i)
+            cancel_timestep = (std::min)(cancel_timestep, val[i]->stop_timestep_);
+
+        std::size_t stop_timestep = (std::min)(last_timestep(par), cancel_timestep);
+
+        if (cancel_timestep != std::size_t(-1)) {
+            result = *val[compute_index];
+            result.timestep_ += level_timestep(par, result.level_);
+        }
+        else if (val[compute_index]->timestep_ < numsteps*finest_steps) {
 
             // copy over critical info
-            resultval->x_.resize(resultval->granularity);
-            resultval->value_.resize(resultval->granularity);
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+            result.x_.resize(result.granularity);
+#endif
+            result.value_.resize(result.granularity);
 
             int level = val[compute_index]->level_;
 
-            had_double_type dt = par->dt0/pow(2.0,level);
-            had_double_type dx = par->dx0/pow(2.0,level);
+            had_double_type dt = par.dt0/double(std::size_t(1) << level);
+            had_double_type dx = level_dx(par, level);
 
             // DEBUG
             //for (int j=0;j<vecx.size()-1;j++) {
-            //  if ( floatcmp(*vecx[j+1]-*vecx[j],dx) == 0 ) {
+            //  if ( stencil::floatcmp(*vecx[j+1]-*vecx[j],dx) == 0 ) {
             //     BOOST_ASSERT(false);
             //  }
             //}
 
             // call rk update
-            int gft = rkupdate(vecval,resultval.get_ptr(),vecx,vecval.size(),
-                                 boundary,bbox,adj_index,dt,dx,val[compute_index]->timestep_,
-                                 level,*par.p);
-
-            // Test for singularity
-            if ( resultval->value_[0].phi[0][0] < 1.e17 ) {
-            } else {
-              FILE *fdata;
-              std::cout << " BLACKHOLE " << std::endl;
-              fdata = fopen("BLACKHOLE","w");
-              fprintf(fdata,"\n");
-              fclose(fdata);
-              BOOST_ASSERT(false);
+            int gft = rkupdate(vecval,&result,vecx,vecval.size(),
+                                 kind,adj_index,dt,dx,val[compute_index]->timestep_,
+                                 level,par);
+
+            // Test for singularity, this ends the evolution on all localities
+            if ( !(result.value_[0].phi[0][0] < 1.e17) ) {
+              cancel_timestep = cancel_evolution(par, evolution_collapsed, result.timestep_);
             }
             BOOST_ASSERT(gft);
 
             // ghostwidth resizing
-            if ( val.size() == 2 ) {
-              if ( resultval->granularity != par->granularity ) {
+            if ( kind == stencil_left_boundary || kind == stencil_right_boundary ) {
+              if ( result.granularity != par.granularity_level[level] ) {
                   // tapering {{{
-
-                  int count = 0;
-                  for (int j=resultval->x_.size()-1;j>=0;j--) {
-                    if ( floatcmp(resultval->x_[j],resultval->g_endx_ - count*resultval->g_dx_) == 1 ) {
-                      count++;
-                    }  else {
-                      resultval->x_.erase(resultval->x_.begin()+j);
-                      resultval->value_.erase(resultval->value_.begin()+j);
-                    }
-                  }
-
-                  resultval->granularity = par->granularity;
-
-                  BOOST_ASSERT(floatcmp(resultval->x_[0],resultval->g_startx_) == 1);
-                  BOOST_ASSERT(floatcmp(resultval->x_[par->granularity-1],resultval->g_endx_) == 1);
-                  BOOST_ASSERT(resultval->x_.size() == par->granularity);
+                  // the points added by the ghostwidth interpolation
+                  // follow the points of the block itself
+                  result.granularity = par.granularity_level[level];
+                  result.value_.resize(result.granularity);
+
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+                  result.x_.resize(result.granularity);
+                  BOOST_ASSERT(stencil::floatcmp(result.x_[0],result.g_startx_) == 1);
+                  BOOST_ASSERT(stencil::floatcmp(result.x_[result.granularity-1],result.g_endx_) == 1);
+#endif
                   // }}}
               }
             }
 
-            if (par->loglevel > 1 && fmod(resultval->timestep_, par->output) < 1.e-6) {
-                stencil_data data (resultval.get());
-                unlock_scoped_values_lock<lcos::local::mutex> ul(l);
-                stubs::logging::logentry(log_, data, row, 0, par);
-            }
+            updated = true;
         }
         else {
             // the last time step has been reached, just copy over the data
-            resultval.get() = val[compute_index].get();
+            result = *val[compute_index];
         }
+        result.stop_timestep_ = cancel_timestep;
+
+        // the other stencils on this locality stop fetching their inputs
+        // right away, without waiting for the cancellation to arrive
+        if (cancel_timestep < local_timestep)
+            note_stop(par.evolution_id, cancel_timestep);
+
         // set return value difference between actual and required number of
         // timesteps (>0: still to go, 0: last step, <0: overdone)
-        if ( val[compute_index]->timestep_ >= par->nt0-2 ) {
+        if ( val[compute_index]->timestep_ >= stop_timestep ) {
           return 0;
         }
         return 1;
     }
 
+
     hpx::actions::manage_object_action<stencil_data> const manage_stencil_data =
         hpx::actions::manage_object_action<stencil_data>();
 
     ///////////////////////////////////////////////////////////////////////////
+    void first_touch(stencil_data& val, std::size_t column, Par const& par)
+    {
+        int level = level_of_column(par, column);
+        BOOST_ASSERT(level >= 0);
+
+        std::size_t capacity = par.granularity_level[level];
+        if (level > 0)
+            capacity += 2*par.granularity_level[level-1] - 1;
+
+        // the capacity is kept while the block is reused
+        val.value_.resize(capacity);
+        val.value_.clear();
+    }
+
+    void first_touch_helper(naming::id_type const& gid, std::size_t column,
+        Parameter const& par, lcos::local::counting_semaphore& sem)
+    {
+        {
+            access_memory_block<stencil_data> val(
+                components::stubs::memory_block::checkout(gid));
+            first_touch(val.get(), column, *par.p);
+        }
+        sem.signal();
+    }
+
     naming::id_type stencil::alloc_data(std::size_t item, std::size_t maxitems,
-        std::size_t row, Parameter const& par)
+        std::size_t row, std::size_t column, Parameter const& par)
     {
         naming::id_type here = applier::get_applier().get_runtime_support_gid();
         naming::id_type result = components::stubs::memory_block::create(
             here, sizeof(stencil_data), manage_stencil_data);
 
+        // the points are written first by a thread running on the worker
+        // thread the stencils of this column are pinned to
+        std::size_t os_thread = numa_os_thread(*par.p, column,
+            hpx::get_os_thread_count());
+        if (os_thread != std::size_t(-1)) {
+            lcos::local::counting_semaphore sem(0);
+            applier::register_thread_nullary(
+                boost::bind(&first_touch_helper, result, column,
+                    boost::cref(par), boost::ref(sem)),
+                "stencil::first_touch", threads::pending, true,
+                threads::thread_priority_normal, os_thread);
+            sem.wait();
+        }
+
         if (-1 != item) {
             // provide initial data for the given data value
             access_memory_block<stencil_data> val(
                 components::stubs::memory_block::checkout(result));
 
-            // call provided (external) function
-            generate_initial_data(val.get_ptr(), item, maxitems, row, *par.p);
+            if (!par->restart.empty() && 0 == row) {
+                // restart from the state stored in the checkpoint file
+                val.get() = read_checkpoint_record(par->restart, item, maxitems);
+                val->stop_timestep_ = std::size_t(-1);
+            }
+            else {
+                // call provided (external) function
+                generate_initial_data(val.get_ptr(), item, maxitems, row, *par.p);
+            }
 
             if (log_ && par->loglevel > 1)         // send initial value to logging instance
                 stubs::logging::logentry(log_, val.get(), row,0, par);
+
+            if (log_ && par->diagnostics &&
+                val->timestep_ % par->output_every == 0) {
+                stubs::logging::diagnostics(log_,
+                    compute_diagnostics(val.get(), *par.p), par);
+            }
         }
         return result;
     }
@@ -413,5 +617,11 @@ namespace hpx { namespace components { namespace amr
         numsteps_ = numsteps;
         log_ = logging;
     }
+
+    void stencil::release_data(Parameter const& par)
+    {
+        if (!par->restart.empty())
+            release_checkpoint(par->restart);
+    }
 }}}
 
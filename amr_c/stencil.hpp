@@ -42,21 +42,27 @@ namespace hpx { namespace components { namespace amr
         /// \a result passes in the gid of the memory block where the result
         /// of the current time step has to be stored. The parameter \a gids
         /// is a vector of gids referencing the memory blocks of the results of
-        /// previous time step.
+        /// previous time step. The parameter \a kind is the kind of the
+        /// stencil (see get_stencil_kind()).
         std::size_t eval(naming::id_type const& result,
             std::vector<naming::id_type> const& gids, std::size_t row, std::size_t column,
-            Parameter const& par);
+            int kind, Parameter const& par);
 
         /// The alloc function is supposed to create a new memory block instance
         /// suitable for storing all data needed for a single time step.
         /// Additionally it fills the memory with initial data for the data
-        /// item given by the parameter \a item (if item != -1).
+        /// item given by the parameter \a item (if item != -1). The memory is
+        /// first touched in the NUMA domain of the given \a column.
         naming::id_type alloc_data(std::size_t item, std::size_t maxitems,
-            std::size_t row, Parameter const& par);
+            std::size_t row, std::size_t column, Parameter const& par);
 
         /// The init function initializes this stencil point
         void init(std::size_t, naming::id_type const&);
 
+        /// The release_data function drops the checkpoint the initial data
+        /// was restarted from, once all columns have been seeded
+        void release_data(Parameter const& par);
+
         /// floating point comparison (for coordinates)
         static bool floatcmp(had_double_type const& x1,had_double_type const& x2);
     private:
@@ -64,6 +70,25 @@ namespace hpx { namespace components { namespace amr
         naming::id_type log_;
     };
 
+    /// The function \a eval_kernel implements the computational part of
+    /// stencil::eval on plain data. It computes the value of the current
+    /// time step of the given column from the inputs \a val, where
+    /// \a offset is the position of the first point of each input in its
+    /// block, and \a kind is the kind of the stencil (see
+    /// get_stencil_kind()). The flag \a updated is set if a time step was
+    /// computed, the return value is the same as for stencil::eval.
+    HPX_COMPONENT_EXPORT std::size_t eval_kernel(stencil_data& result,
+        std::vector<stencil_data*> const& val,
+        std::vector<std::size_t> const& offset, std::size_t column,
+        stencil_kind kind, std::size_t numsteps, Par const& par,
+        bool& updated);
+
+    /// The function \a first_touch reserves the memory for the largest number
+    /// of points a block in the given column may hold (including the points
+    /// added by the ghostwidth interpolation) and writes to it, placing it in
+    /// the NUMA domain of the calling thread.
+    HPX_COMPONENT_EXPORT void first_touch(stencil_data& val,
+        std::size_t column, Par const& par);
 }}}
 
 #endif
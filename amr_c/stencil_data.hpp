@@ -34,7 +34,7 @@ struct stencil_data
 {
     stencil_data()
       : max_index_(0), index_(0), timestep_(0), cycle_(0), granularity(0),
-        level_(0), g_startx_(0),g_endx_(0),g_dx_(0)
+        level_(0), stop_timestep_(size_t(-1)), g_startx_(0),g_endx_(0),g_dx_(0)
     {}
     ~stencil_data() {}
 
@@ -42,7 +42,10 @@ struct stencil_data
       : max_index_(rhs.max_index_), index_(rhs.index_),
         timestep_(rhs.timestep_), cycle_(rhs.cycle_),
         granularity(rhs.granularity), level_(rhs.level_),
-        value_(rhs.value_), x_(rhs.x_),
+        stop_timestep_(rhs.stop_timestep_), value_(rhs.value_),
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        x_(rhs.x_),
+#endif
         g_startx_(rhs.g_startx_),g_endx_(rhs.g_endx_),g_dx_(rhs.g_dx_)
     {
         // intentionally do not copy mutex, new copy will have it's own mutex
@@ -57,8 +60,11 @@ struct stencil_data
             cycle_ = rhs.cycle_;
             granularity = rhs.granularity;
             level_ = rhs.level_;
+            stop_timestep_ = rhs.stop_timestep_;
             value_ = rhs.value_;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
             x_ = rhs.x_;
+#endif
             g_startx_= rhs.g_startx_;
             g_endx_= rhs.g_endx_;
             g_dx_= rhs.g_dx_;
@@ -71,12 +77,15 @@ struct stencil_data
 
     size_t max_index_;   // overall number of data points
     size_t index_;       // sequential number of this data point (0 <= index_ < max_values_)
-    had_double_type timestep_;    // current time step
+    size_t timestep_;    // current time step (in units of the finest level step)
     size_t cycle_;       // counts the number of subcycles
     size_t granularity;
     size_t level_;       // refinement level
+    size_t stop_timestep_;  // time step a cancelled evolution stops at (-1: not cancelled)
     std::vector< nodedata > value_;         // current value
-    std::vector< had_double_type > x_;      // x coordinate value
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+    std::vector< had_double_type > x_;      // x coordinate value (see point_x())
+#endif
     had_double_type g_startx_;
     had_double_type g_endx_;
     had_double_type g_dx_;
@@ -88,8 +97,12 @@ private:
     template<class Archive>
     void serialize(Archive & ar, const unsigned int version)
     {
-        ar & max_index_ & index_ & timestep_ & cycle_ & granularity & level_ & value_;
-        ar & x_ & g_startx_ & g_endx_ & g_dx_;
+        ar & max_index_ & index_ & timestep_ & cycle_ & granularity & level_;
+        ar & stop_timestep_ & value_;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+        ar & x_;
+#endif
+        ar & g_startx_ & g_endx_ & g_dx_;
     }
 };
 
@@ -4,6 +4,7 @@
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
 #include <hpx/hpx_fwd.hpp>
+#include <algorithm>
 #include <cmath>
 #include <stdio.h>
 
@@ -29,11 +30,21 @@ inline int floatcmp(had_double_type const& x1, had_double_type const& x2)
   }
 }
 
+// points closer than this to either end of the data do not have the full
+// dissipation stencil available
+int const dissipation_width = 3;
+
+// the first two RK stages are evaluated this far outside the computed block
+int const rk_width = 7;
+
+// Interior: the compute_index has at least dissipation_width points on
+// either side, none of the boundary and tapering branches apply
+template <int Kind, bool Interior>
 void calcrhs(struct nodedata * rhs,
                std::vector< nodedata* > const& vecval,
                std::vector< had_double_type* > const& vecx,
                 int flag, had_double_type const& dx, int size,
-                bool boundary, int *bbox,int compute_index, Par const& par);
+                int compute_index, Par const& par);
 
 inline had_double_type initial_chi(had_double_type const& r,Par const& par)
 {
@@ -57,38 +68,28 @@ int generate_initial_data(stencil_data* val, std::size_t item,
     val->timestep_ = 0;
     val->cycle_ = 0;
 
-    val->granularity = par.granularity;
-    val->x_.resize(par.granularity);
-    val->value_.resize(par.granularity);
-
     //number of values per stencil_data
     nodedata node;
 
     // find out what level we are at
-    std::size_t level = -1;
-    for (int j=0;j<=par.allowedl;j++) {
-      if (item >= par.level_begin[j] && item < par.level_end[j] ) {
-        level = j;
-        break;
-      }
-    }
+    int level = level_of_column(par, item);
     BOOST_ASSERT(level >= 0);
 
-    val->level_= level;
-    had_double_type dx = par.dx0/pow(2.0,(int) level);
+    int granularity = par.granularity_level[level];
+    val->granularity = granularity;
+#if defined(HAD_AMR_DEBUG_COORDINATES)
+    val->x_.resize(granularity);
+#endif
+    val->value_.resize(granularity);
 
-    had_double_type r_start = 0.0;
-    for (std::size_t j=par.allowedl;j>level;j--) {
-      r_start += (par.level_end[j]-par.level_begin[j])*par.granularity*par.dx0/std::pow(2.0,int(j));
-    }
-    for (std::size_t j=par.level_begin[level];j<item;j++) {
-      r_start += dx*par.granularity;
-    }
+    val->level_= level;
+    had_double_type dx = level_dx(par, level);
+    had_double_type r_start = block_startx(par, level, item);
 
     static had_double_type const c_0 = 0.0;
     static had_double_type const c_0_5 = 0.5;
 
-    for (int i=0;i<par.granularity;i++) {
+    for (int i=0;i<granularity;i++) {
       had_double_type r = r_start + i*dx;
 
       had_double_type chi = initial_chi(r,par);
@@ -96,7 +97,9 @@ int generate_initial_data(stencil_data* val, std::size_t item,
       had_double_type Pi  = c_0;
       had_double_type Energy = c_0_5* r*r * (Pi*Pi + Phi*Phi) - r*r * pow(chi, par.PP+1)/(par.PP+1);
 
+#if defined(HAD_AMR_DEBUG_COORDINATES)
       val->x_[i] = r;
+#endif
 
       node.phi[0][0] = chi;
       node.phi[0][1] = Phi;
@@ -109,16 +112,158 @@ int generate_initial_data(stencil_data* val, std::size_t item,
     return 1;
 }
 
-int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
-  std::vector< had_double_type* > const& vecx, int size, bool boundary,
-  int *bbox, int compute_index,
-  had_double_type const& dt, had_double_type const& dx, had_double_type const& timestep,
-  int level, Par const& par)
+// split [start, end) into the points close to the ends of the data and the
+// interior points: [start, lo) and [hi, end) need the generic treatment
+inline void interior_range(std::size_t start, std::size_t end, int size,
+  std::size_t& lo, std::size_t& hi)
 {
+  lo = (std::max)(start, std::size_t(dissipation_width));
+  hi = end;
+  if ( size - dissipation_width < int(hi) ) {
+    hi = size > dissipation_width ? size - dissipation_width : 0;
+  }
+  if ( lo > end ) lo = end;
+  if ( hi < lo ) hi = lo;
+}
 
+// left boundary: values are determined by quadratic fit, not evolution
+inline void fit_left_boundary(nodedata& v0, nodedata const& v1,
+  nodedata const& v2, int flag)
+{
+  static had_double_type const c_0_5 = 0.5;
+  static had_double_type const c_4_3 = had_double_type(4.)/had_double_type(3.);
+  static had_double_type const c_1_3 = had_double_type(1.)/had_double_type(3.);
 
-  // allocate some temporary arrays for calculating the rhs
+  // chi
+#ifndef UGLIFY
+  v0.phi[flag][0] = c_4_3*v1.phi[flag][0]
+                   -c_1_3*v2.phi[flag][0];
+#else
+  // uglify
+  v0.phi[flag][0] = c_4_3*v1.phi[flag][0];
+  v0.phi[flag][0] -= c_1_3*v2.phi[flag][0];
+#endif
+
+  // Pi
+#ifndef UGLIFY
+  v0.phi[flag][2] = c_4_3*v1.phi[flag][2]
+                   -c_1_3*v2.phi[flag][2];
+#else
+  // uglify
+  v0.phi[flag][2] = c_4_3*v1.phi[flag][2];
+  v0.phi[flag][2] -= c_1_3*v2.phi[flag][2];
+#endif
+}
+
+// iter 0: work = (phi, phi + dt*rhs(phi)) for the points [first, last)
+template <int Kind, bool Interior>
+inline void rk_iter0(std::vector<nodedata>& work,
+  std::vector< nodedata* > const& vecval,
+  std::vector< had_double_type* > const& vecx, std::size_t first,
+  std::size_t last, had_double_type const& dt, had_double_type const& dx,
+  int size, Par const& par)
+{
   nodedata rhs;
+  for (std::size_t j=first; j<last; j++) {
+    calcrhs<Kind, Interior>(&rhs,vecval,vecx,0,dx,size,j,par);
+    for (int i=0; i<num_eqns; i++) {
+      work[j].phi[0][i] = vecval[j]->phi[0][i];
+#ifndef UGLIFY
+      work[j].phi[1][i] = vecval[j]->phi[0][i] + rhs.phi[0][i]*dt;
+#else
+      // uglify
+      work[j].phi[1][i] = dt;
+      work[j].phi[1][i] *= rhs.phi[0][i];
+      work[j].phi[1][i] += vecval[j]->phi[0][i];
+#endif
+    }
+  }
+}
+
+// iter 1: work2 = (phi, 3/4 phi + 1/4 (work + dt*rhs(work)))
+template <int Kind, bool Interior>
+inline void rk_iter1(std::vector<nodedata>& work2,
+  std::vector<nodedata> const& work, std::vector< nodedata* > const& pwork,
+  std::vector< had_double_type* > const& vecx, std::size_t first,
+  std::size_t last, had_double_type const& dt, had_double_type const& dx,
+  int size, Par const& par)
+{
+  static had_double_type const c_0_75 = 0.75;
+  static had_double_type const c_0_25 = 0.25;
+
+  nodedata rhs;
+#ifdef UGLIFY
+  had_double_type tmp;
+#endif
+  for (std::size_t j=first; j<last; j++) {
+    calcrhs<Kind, Interior>(&rhs,pwork,vecx,1,dx,size,j,par);
+    for (int i=0; i<num_eqns; i++) {
+      work2[j].phi[0][i] = work[j].phi[0][i];
+#ifndef UGLIFY
+      work2[j].phi[1][i] = c_0_75*work[j].phi[0][i]
+                          +c_0_25*work[j].phi[1][i] + c_0_25*rhs.phi[0][i]*dt;
+#else
+      // uglify
+      tmp = dt;
+      tmp *= c_0_25;
+      tmp *= rhs.phi[0][i];
+      work2[j].phi[1][i] = work[j].phi[1][i];
+      work2[j].phi[1][i] *= c_0_25;
+      work2[j].phi[1][i] += tmp;
+      tmp = c_0_75;
+      tmp *= work[j].phi[0][i];
+      work2[j].phi[1][i] += tmp;
+#endif
+    }
+  }
+}
+
+// iter 2: result = 1/3 phi + 2/3 (work2 + dt*rhs(work2)) for the points
+// [first, last) of the data (the result starts at compute_index)
+template <int Kind, bool Interior>
+inline void rk_iter2(stencil_data* result, std::vector<nodedata> const& work2,
+  std::vector< nodedata* > const& pwork2,
+  std::vector< had_double_type* > const& vecx, std::size_t first,
+  std::size_t last, int compute_index, had_double_type const& dt,
+  had_double_type const& dx, int size, Par const& par)
+{
+  static had_double_type const c_2_3 = had_double_type(2.)/had_double_type(3.);
+  static had_double_type const c_1_3 = had_double_type(1.)/had_double_type(3.);
+
+  nodedata rhs;
+#ifdef UGLIFY
+  had_double_type tmp;
+#endif
+  for (std::size_t k=first; k<last; k++) {
+    std::size_t const j = k - compute_index;
+    calcrhs<Kind, Interior>(&rhs,pwork2,vecx,1,dx,size,k,par);
+    for (int i=0; i<num_eqns; i++) {
+#ifndef UGLIFY
+      result->value_[j].phi[0][i] = c_1_3*work2[k].phi[0][i]
+                                   +c_2_3*(work2[k].phi[1][i] + rhs.phi[0][i]*dt);
+#else
+      // uglify
+      tmp = c_1_3;
+      tmp *= work2[k].phi[0][i];
+      result->value_[j].phi[0][i] = dt;
+      result->value_[j].phi[0][i] *= rhs.phi[0][i];
+      result->value_[j].phi[0][i] += work2[k].phi[1][i];
+      result->value_[j].phi[0][i] *= c_2_3;
+      result->value_[j].phi[0][i] += tmp;
+#endif
+    }
+  }
+}
+
+// the RK update specialized for the given kind of stencil, the branches
+// depending on the position of a point are taken once per range of points
+template <int Kind>
+int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
+  std::vector< had_double_type* > const& vecx, int size, int compute_index,
+  had_double_type const& dt, had_double_type const& dx, std::size_t timestep,
+  int level, Par const& par)
+{
+  // allocate some temporary arrays for calculating the rhs
   std::vector<nodedata> work;
   std::vector<nodedata> work2;
   std::vector<nodedata* > pwork;
@@ -126,63 +271,30 @@ int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
   work.resize(vecval.size());
   work2.resize(vecval.size());
 
-  static had_double_type const c_1 = 1.;
-  static had_double_type const c_2 = 2.;
-  static had_double_type const c_0_75 = 0.75;
   static had_double_type const c_0_5 = 0.5;
-  static had_double_type const c_0_25 = 0.25;
-
-  static had_double_type const c_4_3 = had_double_type(4.)/had_double_type(3.);
-  static had_double_type const c_2_3 = had_double_type(2.)/had_double_type(3.);
-  static had_double_type const c_1_3 = had_double_type(1.)/had_double_type(3.);
 
 #ifdef UGLIFY
   had_double_type tmp,tmp2;
 #endif
 
+  std::size_t lo, hi;
+
   // -------------------------------------------------------------------------
   // iter 0
     std::size_t start,end;
-    if ( compute_index-7 > 0 ) start = compute_index-7;
+    if ( compute_index-rk_width > 0 ) start = compute_index-rk_width;
     else start = 0;
 
-    if ( compute_index+result->granularity+7 < vecval.size() ) end = compute_index+result->granularity+7;
+    if ( compute_index+result->granularity+rk_width < vecval.size() ) end = compute_index+result->granularity+rk_width;
     else end = vecval.size();
 
-    for (std::size_t j=start;  j<end;j++) {
-      calcrhs(&rhs,vecval,vecx,0,dx,size,boundary,bbox,j,par);
-      for (int i=0; i<num_eqns; i++) {
-        work[j].phi[0][i] = vecval[j]->phi[0][i];
-#ifndef UGLIFY
-        work[j].phi[1][i] = vecval[j]->phi[0][i] + rhs.phi[0][i]*dt;
-#else
-        // uglify
-        work[j].phi[1][i] = dt;
-        work[j].phi[1][i] *= rhs.phi[0][i];
-        work[j].phi[1][i] += vecval[j]->phi[0][i];
-#endif
-      }
-    }
-    if ( boundary && bbox[0] == 1 ) {
-      // chi
-#ifndef UGLIFY
-      work[0].phi[1][0] = c_4_3*work[1].phi[1][0]
-                                   -c_1_3*work[2].phi[1][0];
-#else
-      // uglify
-      work[0].phi[1][0] = c_4_3*work[1].phi[1][0];
-      work[0].phi[1][0] -= c_1_3*work[2].phi[1][0];
-#endif
+    interior_range(start,end,size,lo,hi);
+    rk_iter0<Kind, false>(work,vecval,vecx,start,lo,dt,dx,size,par);
+    rk_iter0<Kind, true>(work,vecval,vecx,lo,hi,dt,dx,size,par);
+    rk_iter0<Kind, false>(work,vecval,vecx,hi,end,dt,dx,size,par);
 
-      // Pi
-#ifndef UGLIFY
-      work[0].phi[1][2] = c_4_3*work[1].phi[1][2]
-                                   -c_1_3*work[2].phi[1][2];
-#else
-      // uglify
-      work[0].phi[1][2] = c_4_3*work[1].phi[1][2];
-      work[0].phi[1][2] -= c_1_3*work[2].phi[1][2];
-#endif
+    if ( Kind == stencil_left_boundary ) {
+      fit_left_boundary(work[0],work[1],work[2],1);
 
       // Phi
       work[1].phi[1][1] = c_0_5*work[2].phi[1][1];
@@ -193,48 +305,13 @@ int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
 
   //----------------------------------------------------------------------
   // iter 1
-    for (std::size_t j=start; j<end; j++) {
-      calcrhs(&rhs,pwork,vecx,1,dx,size,boundary,bbox,j,par);
-      for (int i=0; i<num_eqns; i++) {
-        work2[j].phi[0][i] = work[j].phi[0][i];
-#ifndef UGLIFY
-        work2[j].phi[1][i] = c_0_75*work[j].phi[0][i]
-                            +c_0_25*work[j].phi[1][i] + c_0_25*rhs.phi[0][i]*dt;
-#else
-        // uglify
-        tmp = dt;
-        tmp *= c_0_25;
-        tmp *= rhs.phi[0][i];
-        work2[j].phi[1][i] = work[j].phi[1][i];
-        work2[j].phi[1][i] *= c_0_25;
-        work2[j].phi[1][i] += tmp;
-        tmp = c_0_75;
-        tmp *= work[j].phi[0][i];
-        work2[j].phi[1][i] += tmp;
-#endif
-      }
-    }
-
-    if ( boundary && bbox[0] == 1 ) {
-      // chi
-#ifndef UGLIFY
-      work2[0].phi[1][0] = c_4_3*work[1].phi[1][0]
-                          -c_1_3*work[2].phi[1][0];
-#else
-      // uglify
-      work2[0].phi[1][0] = c_4_3*work[1].phi[1][0];
-      work2[0].phi[1][0] -= c_1_3*work[2].phi[1][0];
-#endif
+    rk_iter1<Kind, false>(work2,work,pwork,vecx,start,lo,dt,dx,size,par);
+    rk_iter1<Kind, true>(work2,work,pwork,vecx,lo,hi,dt,dx,size,par);
+    rk_iter1<Kind, false>(work2,work,pwork,vecx,hi,end,dt,dx,size,par);
 
-      // Pi
-#ifndef UGLIFY
-      work2[0].phi[1][2] = c_4_3*work[1].phi[1][2]
-                          -c_1_3*work[2].phi[1][2];
-#else
-      // uglify
-      work2[0].phi[1][2] = c_4_3*work[1].phi[1][2];
-      work2[0].phi[1][2] -= c_1_3*work[2].phi[1][2];
-#endif
+    if ( Kind == stencil_left_boundary ) {
+      // note: the fit uses the values of iter 0
+      fit_left_boundary(work2[0],work[1],work[2],1);
 
       // Phi
       work2[1].phi[1][1] = c_0_5*work[2].phi[1][1];
@@ -245,44 +322,17 @@ int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
 
   //----------------------------------------------------------------------
   // iter 2
-    for (std::size_t j=0; j<result->granularity; j++) {
-      calcrhs(&rhs,pwork2,vecx,1,dx,size,boundary,bbox,j+compute_index,par);
-      for (int i=0; i<num_eqns; i++) {
-#ifndef UGLIFY
-        result->value_[j].phi[0][i] = c_1_3*work2[j+compute_index].phi[0][i]
-                                     +c_2_3*(work2[j+compute_index].phi[1][i] + rhs.phi[0][i]*dt);
-#else
-        // uglify
-        tmp = c_1_3;
-        tmp *= work2[j+compute_index].phi[0][i];
-        result->value_[j].phi[0][i] = dt;
-        result->value_[j].phi[0][i] *= rhs.phi[0][i];
-        result->value_[j].phi[0][i] += work2[j+compute_index].phi[1][i];
-        result->value_[j].phi[0][i] *= c_2_3;
-        result->value_[j].phi[0][i] += tmp;
-#endif
-      }
-    }
+    start = compute_index;
+    end = compute_index+result->granularity;
+
+    interior_range(start,end,size,lo,hi);
+    rk_iter2<Kind, false>(result,work2,pwork2,vecx,start,lo,compute_index,dt,dx,size,par);
+    rk_iter2<Kind, true>(result,work2,pwork2,vecx,lo,hi,compute_index,dt,dx,size,par);
+    rk_iter2<Kind, false>(result,work2,pwork2,vecx,hi,end,compute_index,dt,dx,size,par);
+
+    if ( Kind == stencil_left_boundary ) {
+      fit_left_boundary(result->value_[0],result->value_[1],result->value_[2],0);
 
-    if ( boundary && bbox[0] == 1 ) {
-      // chi
-#ifndef UGLIFY
-      result->value_[0].phi[0][0] = c_4_3*result->value_[1].phi[0][0]
-                                   -c_1_3*result->value_[2].phi[0][0];
-#else
-      // uglify
-      result->value_[0].phi[0][0] = c_4_3*result->value_[1].phi[0][0];
-      result->value_[0].phi[0][0] -= c_1_3*result->value_[2].phi[0][0];
-#endif
-      // Pi
-#ifndef UGLIFY
-      result->value_[0].phi[0][2] = c_4_3*result->value_[1].phi[0][2]
-                                   -c_1_3*result->value_[2].phi[0][2];
-#else
-      // uglify
-      result->value_[0].phi[0][2] = c_4_3*result->value_[1].phi[0][2];
-      result->value_[0].phi[0][2] -= c_1_3*result->value_[2].phi[0][2];
-#endif
       // Phi
       result->value_[1].phi[0][1] = c_0_5*result->value_[2].phi[0][1];
     }
@@ -290,13 +340,13 @@ int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
     // Calculate the energy
     for (std::size_t j=0; j<result->granularity; j++) {
 #ifndef UGLIFY
-        result->value_[j].energy = c_0_5*(*vecx[j])*(*vecx[j])*(
+        result->value_[j].energy = c_0_5*(*vecx[j+compute_index])*(*vecx[j+compute_index])*(
                                   result->value_[j].phi[0][2]*result->value_[j].phi[0][2] // Pi^2
                                 + result->value_[j].phi[0][1]*result->value_[j].phi[0][1]) // Phi^2
-                                   -(*vecx[j])*(*vecx[j])*pow(result->value_[j].phi[0][0],par.PP+1)/(par.PP+1);
+                                   -(*vecx[j+compute_index])*(*vecx[j+compute_index])*pow(result->value_[j].phi[0][0],par.PP+1)/(par.PP+1);
 #else
-        tmp = *vecx[j];
-        tmp *= *vecx[j];
+        tmp = *vecx[j+compute_index];
+        tmp *= *vecx[j+compute_index];
         result->value_[j].energy = result->value_[j].phi[0][2];
         result->value_[j].energy *= result->value_[j].phi[0][2];
         tmp2 = result->value_[j].phi[0][1];
@@ -311,26 +361,43 @@ int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
 #endif
     }
 
-    // timestep update
-#ifndef UGLIFY
-    result->timestep_ = timestep + 1.0/pow(2.0,level);
-#else
-    // uglify
-    tmp = pow(c_2,level);
-    result->timestep_ = c_1;
-    result->timestep_ /= tmp;
-    result->timestep_ += timestep;
-#endif
+    // timestep update (counted in finest level steps)
+    result->timestep_ = timestep + level_timestep(par, level);
 
   return 1;
 }
 
+int rkupdate(std::vector< nodedata* > const& vecval, stencil_data* result,
+  std::vector< had_double_type* > const& vecx, int size, stencil_kind kind,
+  int compute_index,
+  had_double_type const& dt, had_double_type const& dx, std::size_t timestep,
+  int level, Par const& par)
+{
+  // the ghostwidth treatment of CASE I and CASE II is done by the caller,
+  // the update itself is the same as for interior stencils
+  switch (kind) {
+  case stencil_left_boundary:
+    return rkupdate<stencil_left_boundary>(vecval,result,vecx,size,
+      compute_index,dt,dx,timestep,level,par);
+
+  case stencil_right_boundary:
+    return rkupdate<stencil_right_boundary>(vecval,result,vecx,size,
+      compute_index,dt,dx,timestep,level,par);
+
+  default:
+    break;
+  }
+  return rkupdate<stencil_interior>(vecval,result,vecx,size,
+    compute_index,dt,dx,timestep,level,par);
+}
+
 // This is a pointwise calculation: compute the rhs for point result given input values in array phi
+template <int Kind, bool Interior>
 void calcrhs(struct nodedata * rhs,
                std::vector< nodedata* > const& vecval,
                std::vector< had_double_type* > const& vecx,
                 int flag, had_double_type const& dx, int size,
-                bool boundary, int *bbox,int compute_index, Par const& par)
+                int compute_index, Par const& par)
 {
   static had_double_type const c_m1 = -1.;
   static had_double_type const c_2 = 2.;
@@ -359,7 +426,8 @@ void calcrhs(struct nodedata * rhs,
   // are available for computing the rhs.
 
   // Add  dissipation if size = 7
-  if ( compute_index + 3 < size && compute_index - 3 >= 0 ) {
+  if ( Interior ||
+       (compute_index + dissipation_width < size && compute_index - dissipation_width >= 0) ) {
 #ifndef UGLIFY
     diss_chi = c_m1/(c_64*dr)*(  -vecval[compute_index-3]->phi[flag][0]
                              +c_6*vecval[compute_index-2]->phi[flag][0]
@@ -458,7 +526,7 @@ void calcrhs(struct nodedata * rhs,
   }
 
 
-  if ( compute_index + 1 < size && compute_index - 1 >= 0 ) {
+  if ( Interior || (compute_index + 1 < size && compute_index - 1 >= 0) ) {
 
     /*
     had_double_type const& chi_np1 = vecval[compute_index+1]->phi[flag][0];
@@ -545,16 +613,16 @@ void calcrhs(struct nodedata * rhs,
     rhs->phi[0][2] = c_0; // Pi rhs -- chi is set by quadratic fit
   }
 
-  if (boundary ) {
-    // boundary -- look at the bounding box (bbox) to decide which boundary it is
-    if ( bbox[0] == 1 && compute_index == 0 ) {
+  if ( !Interior ) {
+    // boundary -- the kind of the stencil decides which boundary it is
+    if ( Kind == stencil_left_boundary && compute_index == 0 ) {
       // we are at the left boundary  -- values are determined by quadratic fit, not evolution
 
       rhs->phi[0][0] = c_0; // chi rhs -- chi is set by quadratic fit
       rhs->phi[0][1] = c_0; // Phi rhs -- Phi-dot is always zero at r=0
       rhs->phi[0][2] = c_0; // Pi rhs -- chi is set by quadratic fit
     }
-    if (bbox[1] == 1 && compute_index == size-1) {
+    if ( Kind == stencil_right_boundary && compute_index == size-1 ) {
 
       had_double_type const& Phi_nm1 = vecval[size-2]->phi[flag][1];
       had_double_type const& Phi_nm2 = vecval[size-3]->phi[flag][1];
@@ -7,6 +7,7 @@
 #define AMR_C_FUNCTIONS_FEB_16_2009_0141PM
 
 #include <hpx/config/export_definitions.hpp>
+#include <boost/assert.hpp>
 #include "../parameter.h"
 #include "../had_config.hpp"
 
@@ -24,11 +25,12 @@ HAD_AMR_C_TEST_EXPORT int generate_initial_data(
             Par const& par);
 
 /// The function \a evaluate_timestep will be called to compute the result data
-/// for the given timestep
+/// for the given timestep, it dispatches once to the update specialized for
+/// the given kind of stencil
 HAD_AMR_C_TEST_EXPORT int rkupdate(std::vector< nodedata* > const& val,
     stencil_data* result, std::vector< had_double_type* > const& vecx, int size,
-    bool boundary, int *bbox, int compute_index,
-    had_double_type const&, had_double_type const&, had_double_type const&,
+    stencil_kind kind, int compute_index,
+    had_double_type const&, had_double_type const&, std::size_t,
     int level, Par const& par);
 
 #endif
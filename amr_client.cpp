@@ -3,6 +3,7 @@
 //  Distributed under the Boost Software License, Version 1.0. (See accompanying
 //  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
 
+#include <cstdio>
 #include <cstring>
 #include <iostream>
 
@@ -17,11 +18,17 @@
 #include "amr/dynamic_stencil_value.hpp"
 #include "amr/functional_component.hpp"
 #include "amr/unigrid_mesh.hpp"
+#include "amr/performance_counters.hpp"
+#include "amr/cancellation.hpp"
 #include "amr_c/stencil.hpp"
 #include "amr_c/logging.hpp"
+#include "amr_c/checkpoint.hpp"
 
 #include "amr_c_test/rand.hpp"
 
+#include "amr_autotune.hpp"
+#include "amr_bisection.hpp"
+
 namespace po = boost::program_options;
 
 using namespace hpx;
@@ -39,21 +46,42 @@ int hpx_main(std::size_t numvals, std::size_t numsteps,bool do_logging,
     {
         naming::id_type here = applier::get_applier().get_runtime_support_gid();
 
-        if ( par->loglevel > 0 ) {
-          // over-ride a false command line argument
+        if ( par->loglevel > 0 || par->checkpoint_every > 0 || par->diagnostics ) {
+          // over-ride a false command line argument (the checkpoints and
+          // the diagnostics are written by the logging instance)
           do_logging = true;
         }
 
         hpx::util::high_resolution_timer t;
-        std::vector<naming::id_type> result_data;
+        components::amr::evolution_result result;
 
         // we are in spherical symmetry, r=0 is the smallest radial domain point
         components::amr::unigrid_mesh unigrid_mesh;
         unigrid_mesh.create(here);
-        result_data = unigrid_mesh.init_execute(function_type, numvals, numsteps,
+        result = unigrid_mesh.init_execute(function_type, numvals, numsteps,
             do_logging ? logging_type : components::component_invalid,par);
         printf("Elapsed time: %f s\n", t.elapsed());
 
+        // report how the evolution ended
+        components::amr::evolution_status const& status = result.status_;
+        if ( status.outcome_ != components::amr::evolution_completed ) {
+          printf("Outcome: %s at t = %g\n",
+              components::amr::get_outcome_name(status.outcome_),
+              double(timestep_to_time(status.timestep_, *par.p)));
+        } else {
+          printf("Outcome: %s\n",
+              components::amr::get_outcome_name(status.outcome_));
+        }
+        if ( status.outcome_ == components::amr::evolution_collapsed ) {
+          std::cout << " BLACKHOLE " << std::endl;
+          FILE *fdata = fopen("BLACKHOLE","w");
+          fprintf(fdata,"\n");
+          fclose(fdata);
+        }
+
+        // show how the time was split between the phases of init_execute
+        components::amr::print_phase_timings(std::cout);
+
     // provide some wait time to read the elapsed time measurement
     //std::cout << " Hit return " << std::endl;
     //int junk;
@@ -62,18 +90,18 @@ int hpx_main(std::size_t numvals, std::size_t numsteps,bool do_logging,
         // get some output memory_block_data instances
         /*
         std::cout << "Results: " << std::endl;
-        for (std::size_t i = 0; i < result_data.size(); ++i)
+        for (std::size_t i = 0; i < result.result_data_.size(); ++i)
         {
             components::access_memory_block<components::amr::stencil_data> val(
-                components::stubs::memory_block::get(result_data[i]));
+                components::stubs::memory_block::get(result.result_data_[i]));
             std::cout << i << ": " << val->value_ << std::endl;
         }
         */
 
 //         boost::this_thread::sleep(boost::posix_time::seconds(3));
 
-//         for (std::size_t i = 0; i < result_data.size(); ++i)
-//             components::stubs::memory_block::free(result_data[i]);
+//         for (std::size_t i = 0; i < result.result_data_.size(); ++i)
+//             components::stubs::memory_block::free(result.result_data_[i]);
     }   // amr_mesh needs to go out of scope before shutdown
 
     // initiate shutdown of the runtime systems on all localities
@@ -93,30 +121,17 @@ int hpx_main(po::variables_map & vm)
     components::amr::Parameter par;
 
     // default pars
-    par->allowedl    = 0;
-    par->loglevel    = 2;
-    par->output      = 1.0;
+    int nx0;
+    components::amr::set_default_parameters(par, nx0, numsteps);
     par->output_stdout = do_logging;
-    par->lambda      = 0.15;
-    int nx0          = 33;
-    par->nt0         = numsteps;
-    par->minx0       =   0.0;
-    par->maxx0       =  15.0;
-    par->ethreshold  =  0.005;
-    par->R0          =  8.0;
-    par->amp         =  0.1;
-    par->delta       =  1.0;
-    par->PP          =  7;
-    par->eps         =  0.0;
-    par->output_level =  0;
-    par->granularity =  3;
-    for (int i=0;i<maxlevels;i++) {
-      // default
-      par->refine_level[i] = 1.5;
-    }
 
-    int scheduler = 1;  // 0: global scheduler
-                        // 1: parallel scheduler
+    // pick the granularity by running short calibration evolutions
+    bool autotune = vm.count("autotune") ? true : false;
+    std::size_t autotune_steps = 6;
+
+    // search the critical amplitude by running concurrent evolutions
+    bool bisect = vm.count("bisect") ? true : false;
+    bisection::settings bisect_settings;
     std::string parfile;
     if (vm.count("parfile")) {
         parfile = vm["parfile"].as<std::string>();
@@ -124,139 +139,78 @@ int hpx_main(po::variables_map & vm)
 
         if ( pars.has_section("had_amr") ) {
           hpx::util::section *sec = pars.get_section("had_amr");
-          if ( sec->has_entry("lambda") ) {
-            std::string tmp = sec->get_entry("lambda");
-            par->lambda = atof(tmp.c_str());
-          }
-          if ( sec->has_entry("allowedl") ) {
-            std::string tmp = sec->get_entry("allowedl");
-            par->allowedl = atoi(tmp.c_str());
-          }
-          if ( sec->has_entry("loglevel") ) {
-            std::string tmp = sec->get_entry("loglevel");
-            par->loglevel = atoi(tmp.c_str());
-          }
-          if ( sec->has_entry("output") ) {
-            std::string tmp = sec->get_entry("output");
-            par->output = atof(tmp.c_str());
-          }
-          if ( sec->has_entry("output_stdout") ) {
-            std::string tmp = sec->get_entry("output_stdout");
-            par->output_stdout = atoi(tmp.c_str());
-          }
-          if ( sec->has_entry("output_level") ) {
-            std::string tmp = sec->get_entry("output_level");
-            par->output_level = atoi(tmp.c_str());
-          }
-          if ( sec->has_entry("nx0") ) {
-            std::string tmp = sec->get_entry("nx0");
-            nx0 = atoi(tmp.c_str());
-          }
-          if ( sec->has_entry("nt0") ) {
-            std::string tmp = sec->get_entry("nt0");
-            par->nt0 = atoi(tmp.c_str());
-            // over-ride command line argument if present
-            numsteps = par->nt0;
-          }
-          if ( sec->has_entry("thread_scheduler") ) {
-            std::string tmp = sec->get_entry("thread_scheduler");
-            scheduler = atoi(tmp.c_str());
-            BOOST_ASSERT( scheduler == 0 || scheduler == 1 );
-          }
-          if ( sec->has_entry("maxx0") ) {
-            std::string tmp = sec->get_entry("maxx0");
-            par->maxx0 = atof(tmp.c_str());
-          }
-          if ( sec->has_entry("ethreshold") ) {
-            std::string tmp = sec->get_entry("ethreshold");
-            par->ethreshold = atof(tmp.c_str());
+          components::amr::read_parameters(*sec, par, nx0);
+
+          // over-ride command line argument if present
+          numsteps = par->nt0;
+
+          if ( sec->has_entry("autotune") ) {
+            std::string tmp = sec->get_entry("autotune");
+            autotune = atoi(tmp.c_str()) != 0;
           }
-          if ( sec->has_entry("R0") ) {
-            std::string tmp = sec->get_entry("R0");
-            par->R0 = atof(tmp.c_str());
+          if ( sec->has_entry("autotune_steps") ) {
+            std::string tmp = sec->get_entry("autotune_steps");
+            autotune_steps = atoi(tmp.c_str());
           }
-          if ( sec->has_entry("delta") ) {
-            std::string tmp = sec->get_entry("delta");
-            par->delta = atof(tmp.c_str());
+          if ( sec->has_entry("bisect") ) {
+            std::string tmp = sec->get_entry("bisect");
+            bisect = atoi(tmp.c_str()) != 0;
           }
-          if ( sec->has_entry("amp") ) {
-            std::string tmp = sec->get_entry("amp");
-            par->amp = atof(tmp.c_str());
+          if ( sec->has_entry("bisect_amp_min") ) {
+            std::string tmp = sec->get_entry("bisect_amp_min");
+            bisect_settings.amp_min_ = atof(tmp.c_str());
           }
-          if ( sec->has_entry("PP") ) {
-            std::string tmp = sec->get_entry("PP");
-            par->PP = atoi(tmp.c_str());
+          if ( sec->has_entry("bisect_amp_max") ) {
+            std::string tmp = sec->get_entry("bisect_amp_max");
+            bisect_settings.amp_max_ = atof(tmp.c_str());
           }
-          if ( sec->has_entry("eps") ) {
-            std::string tmp = sec->get_entry("eps");
-            par->eps = atof(tmp.c_str());
+          if ( sec->has_entry("bisect_width") ) {
+            std::string tmp = sec->get_entry("bisect_width");
+            bisect_settings.width_ = atoi(tmp.c_str());
           }
-          if ( sec->has_entry("granularity") ) {
-            std::string tmp = sec->get_entry("granularity");
-            par->granularity = atoi(tmp.c_str());
-           // if ( par->granularity < 3 ) {
-           //   std::cerr << " Problem: granularity must be at least 3 : " << par->granularity << std::endl;
-           //   BOOST_ASSERT(false);
-           // }
+          if ( sec->has_entry("bisect_tolerance") ) {
+            std::string tmp = sec->get_entry("bisect_tolerance");
+            bisect_settings.tolerance_ = atof(tmp.c_str());
           }
-          for (int i=0;i<par->allowedl;i++) {
-            char tmpname[80];
-            sprintf(tmpname,"refine_level_%d",i);
-            if ( sec->has_entry(tmpname) ) {
-              std::string tmp = sec->get_entry(tmpname);
-              par->refine_level[i] = atof(tmp.c_str());
-            }
+          if ( sec->has_entry("bisect_iterations") ) {
+            std::string tmp = sec->get_entry("bisect_iterations");
+            bisect_settings.iterations_ = atoi(tmp.c_str());
           }
-
         }
     }
 
 
-    // derived parameters
-    if ( nx0%par->granularity != 0 ) {
-      std::cerr << " PROBLEM : nx0 must be divisible by the granularity " << std::endl;
-      std::cerr << " nx0 " << nx0 << " granularity " << par->granularity << std::endl;
-      BOOST_ASSERT(false);
+    // report all mistakes in the parameters before starting anything
+    if ( !components::amr::check_parameters(par, nx0) ) {
+      hpx::finalize();
+      return 1;
     }
-    par->nx0 = nx0/par->granularity;
 
-    par->nx[0] = par->nx0;
-    for (int i=1;i<par->allowedl+1;i++) {
-      par->nx[i] = int(par->refine_level[i-1]*par->nx[i-1]);
+    if ( autotune ) {
+      par->granularity = autotune::find_granularity(par, nx0, autotune_steps);
     }
 
-    for (int j=0;j<=par->allowedl;j++) {
-      par->rowsize.push_back(par->nx[par->allowedl]);
-      for (int i=par->allowedl-1;i>=j;i--) {
-        // remove duplicates
-        par->rowsize[j] += par->nx[i] - (par->nx[i+1]+1)/2;
-      }
-    }
-
-    for (int j=0;j<=par->allowedl;j++) {
-      if ( j != par->allowedl ) par->level_begin.push_back(par->rowsize[j+1]);
-      else par->level_begin.push_back(0);
-      par->level_end.push_back(par->rowsize[j]);
-    }
-
-    // Compute dx
-    had_double_type tmp = 0.0;
-    for (int j=par->allowedl;j>0;j--) {
-      tmp += (par->level_end[j]-par->level_begin[j])*par->granularity/pow(2.0,j);
-    }
-
-    for (int j=par->level_begin[0];j<par->rowsize[0]-1;j++) {
-      tmp += par->granularity;
-    }
-
-    par->dx0 = (par->maxx0 - par->minx0)/(tmp + par->granularity-1);
-
-    //par->dx0 = (par->maxx0 - par->minx0)/((par->nx0-1)*par->granularity);
-    par->dt0 = par->lambda*par->dx0;
+    // derived parameters
+    components::amr::compute_derived_parameters(par, nx0);
 
     // figure out the number of points
     numvals = par->rowsize[0];
 
+    if ( bisect ) {
+      // default to twice the amplitude of the parameter file
+      if ( bisect_settings.amp_max_ <= bisect_settings.amp_min_ ) {
+        bisect_settings.amp_max_ = 2.0*par->amp;
+      }
+      bisection::bracket b =
+          bisection::find_critical_amplitude(par, numsteps, bisect_settings);
+      if ( b.valid_ ) {
+        printf("Critical amplitude between %.17g (dispersal) and %.17g (collapse), "
+               "%lu evolutions\n", b.subcritical_, b.supercritical_,
+               (unsigned long)b.evolutions_);
+      }
+      return hpx::finalize();
+    }
+
     //had_double_type tmp2 = 3*pow(2,par->allowedl);
     //int num_rows = (int) tmp2;
     //numsteps = numsteps*3 - 2;
@@ -286,6 +240,22 @@ int hpx_main(po::variables_map & vm)
     fdata = fopen("logcode2.dat","w");
     fprintf(fdata,"\n");
     fclose(fdata);
+
+    if ( par->diagnostics ) {
+      fdata = fopen(components::amr::diagnostics_filename(*par.p).c_str(),"w");
+      fprintf(fdata,"# time energy max|chi| x(max|chi|)\n");
+      fclose(fdata);
+    }
+
+    // remove stale checkpoints, records are appended to these files
+    if ( par->checkpoint_every > 0 ) {
+      std::size_t const finest_steps = level_timestep(*par.p, 0);
+      for (std::size_t t = par->checkpoint_every; t < numsteps*finest_steps;
+           t += par->checkpoint_every) {
+        std::string name = components::amr::checkpoint_filename(t);
+        if ( name != par->restart ) std::remove(name.c_str());
+      }
+    }
     return hpx_main(numvals, numsteps, do_logging, par);
 }
 
@@ -302,9 +272,13 @@ int main(int argc, char* argv[])
             ("parfile,p", po::value<std::string>(),
                 "the parameter file")
             ("verbose,v", "print calculated values after each time step")
+            ("autotune,a", "select the granularity by running short "
+                "calibration evolutions (cached in had_amr_autotune.cache)")
+            ("bisect,b", "search the critical amplitude between the "
+                "bisect_amp_min and bisect_amp_max of the parameter file")
         ;
 
-        hpx::init(desc_cmdline, argc, argv);
+        return hpx::init(desc_cmdline, argc, argv);
     }
     catch (std::exception& e) {
         std::cerr << "std::exception caught: " << e.what() << "\n";
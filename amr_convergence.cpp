@@ -0,0 +1,281 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Convergence test for had_amr: the same evolution is run with nx0, 2*nx0
+// and 4*nx0 points on the coarsest level for each of the selected orders of
+// the coarse-fine interpolation. The number of blocks does not translate
+// into the grid spacing exactly, so the outer boundary of the finer runs is
+// moved to get 1/2 and 1/4 of the grid spacing of the first run. With 1, 2
+// and 4 times the number of steps all runs reach the same final time. The
+// differences between the solutions give the convergence factor
+// Q = |u(nx0) - u(2nx0)| / |u(2nx0) - u(4nx0)|, which is 4 for a second
+// order scheme.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include "amr/functional_component.hpp"
+#include "amr/unigrid_mesh.hpp"
+#include "amr_c/stencil.hpp"
+#include "amr_c/stencil_data.hpp"
+
+namespace po = boost::program_options;
+
+using namespace hpx;
+
+///////////////////////////////////////////////////////////////////////////////
+namespace convergence
+{
+    typedef components::amr::Parameter Parameter;
+
+    // chi as a function of r at the final time, sorted by r
+    typedef std::vector<std::pair<double, double> > profile_type;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // set up a parameter set using the defaults of had_amr_client, with the
+    // given grid spacing dx on the coarsest level (if not zero), returns
+    // false if the parameters are rejected
+    bool make_parameters(Parameter& par, int granularity, int allowedl,
+        int nx0, std::size_t numsteps, int order, double dx)
+    {
+        int default_nx0;
+        components::amr::set_default_parameters(par, default_nx0, numsteps);
+        par->allowedl    = allowedl;
+        par->loglevel    = 0;
+        par->granularity = granularity;
+        par->prolongation_order = order;
+
+        if (!components::amr::check_parameters(par, nx0))
+            return false;
+
+        components::amr::compute_derived_parameters(par, nx0);
+
+        // the grid spacing is proportional to the extent of the domain
+        if (dx > 0.0) {
+            par->maxx0 = par->minx0 + dx*(par->maxx0 - par->minx0)/par->dx0;
+            components::amr::compute_derived_parameters(par, nx0);
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // run a single evolution, return the solution at the final time
+    profile_type run(Parameter const& par, std::size_t numsteps,
+        double& elapsed, double& time)
+    {
+        components::component_type function_type =
+            components::get_component_type<components::amr::stencil>();
+
+        naming::id_type here = applier::get_applier().get_runtime_support_gid();
+
+        std::vector<naming::id_type> result_data;
+        hpx::util::high_resolution_timer t;
+        {
+            components::amr::unigrid_mesh unigrid_mesh;
+            unigrid_mesh.create(here);
+            result_data = unigrid_mesh.init_execute(function_type,
+                par->rowsize[0], numsteps, components::component_invalid,
+                par).result_data_;
+        }
+        elapsed = t.elapsed();
+
+        // only the blocks which reached the final time are compared
+        std::vector<components::access_memory_block<stencil_data> > vals;
+        std::size_t last = 0;
+        for (std::size_t i = 0; i < result_data.size(); ++i) {
+            vals.push_back(components::access_memory_block<stencil_data>(
+                components::stubs::memory_block::get(result_data[i])));
+            last = (std::max)(last, vals.back()->timestep_);
+        }
+        time = double(timestep_to_time(last, *par.p));
+
+        // (r, level, chi), the finest level wins where levels overlap
+        std::vector<std::pair<std::pair<double, int>, double> > points;
+        for (std::size_t i = 0; i < vals.size(); ++i) {
+            stencil_data const& val = vals[i].get();
+            if (val.timestep_ != last)
+                continue;
+
+            for (std::size_t j = 0; j < val.value_.size(); ++j) {
+                double r = double(point_x(*par.p, val.level_, val.index_, j));
+                points.push_back(std::make_pair(
+                    std::make_pair(r, -int(val.level_)),
+                    double(val.value_[j].phi[0][0])));
+            }
+        }
+        std::sort(points.begin(), points.end());
+
+        profile_type profile;
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            double r = points[i].first.first;
+            if (!profile.empty() && std::fabs(profile.back().first - r) < 1.e-10)
+                continue;
+            profile.push_back(std::make_pair(r, points[i].second));
+        }
+        return profile;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // cubic interpolation of the profile at r (r inside the profile)
+    double interpolate(profile_type const& p, double r)
+    {
+        std::size_t k = std::lower_bound(p.begin(), p.end(),
+            std::make_pair(r, -1.e300)) - p.begin();
+        std::size_t first = (k >= 2) ? k - 2 : 0;
+        if (first + 4 > p.size()) first = p.size() - 4;
+
+        double result = 0.0;
+        for (std::size_t i = first; i < first + 4; ++i) {
+            double w = 1.0;
+            for (std::size_t j = first; j < first + 4; ++j) {
+                if (j != i)
+                    w *= (r - p[j].first) / (p[i].first - p[j].first);
+            }
+            result += w * p[i].second;
+        }
+        return result;
+    }
+
+    // l2 norm of the difference of two profiles, taken at the points of the
+    // coarser one up to rmax
+    double difference(profile_type const& coarse, profile_type const& fine,
+        double rmax)
+    {
+        double sum = 0.0;
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < coarse.size(); ++i) {
+            double r = coarse[i].first;
+            if (r < fine.front().first || r > fine.back().first || r > rmax)
+                continue;
+
+            double d = coarse[i].second - interpolate(fine, r);
+            sum += d * d;
+            ++count;
+        }
+        return count ? std::sqrt(sum / count) : 0.0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(po::variables_map& vm)
+{
+    int nx0 = vm["nx0"].as<int>();
+    int granularity = vm["granularity"].as<int>();
+    int allowedl = vm["allowedl"].as<int>();
+    std::size_t numsteps = vm["numsteps"].as<std::size_t>();
+
+    std::vector<int> orders;
+    if (vm.count("prolongation-order")) {
+        orders.push_back(vm["prolongation-order"].as<int>());
+    }
+    else {
+        orders.push_back(2);
+        orders.push_back(4);
+        orders.push_back(6);
+    }
+
+    FILE* fdata = std::fopen("convergence.dat", "w");
+    std::fprintf(fdata, "# order nx0 seconds difference Q\n");
+
+    for (std::size_t o = 0; o < orders.size(); ++o)
+    {
+        convergence::profile_type profiles[3];
+        double elapsed[3];
+        double times[3];
+        double dx = 0.0;
+        double rmax = 0.0;
+        for (int k = 0; k < 3; ++k) {
+            convergence::Parameter par;
+            if (!convergence::make_parameters(par, granularity, allowedl,
+                    nx0 << k, numsteps << k, orders[o], dx / (1 << k)))
+            {
+                std::fclose(fdata);
+                hpx::finalize();
+                return 1;
+            }
+            if (k == 0) {
+                dx = double(par->dx0);
+                rmax = double(par->maxx0);
+            }
+            rmax = (std::min)(rmax, double(par->maxx0));
+            profiles[k] = convergence::run(par, numsteps << k, elapsed[k],
+                times[k]);
+        }
+
+        // the solutions can be compared at the same time only
+        if (std::fabs(times[1] - times[0]) > 1.e-10*times[0] ||
+            std::fabs(times[2] - times[0]) > 1.e-10*times[0])
+        {
+            std::cerr << " convergence: the final times differ: " << times[0]
+                      << " " << times[1] << " " << times[2] << std::endl;
+            std::fclose(fdata);
+            hpx::finalize();
+            return 1;
+        }
+
+        // the outer boundaries differ, leave out the points they influenced
+        rmax -= times[0];
+
+        double d01 = convergence::difference(profiles[0], profiles[1], rmax);
+        double d12 = convergence::difference(profiles[1], profiles[2], rmax);
+        double Q = (d12 > 0.0) ? d01 / d12 : 0.0;
+
+        std::cout << " prolongation_order " << orders[o]
+                  << " Q " << Q << " (order " << std::log(Q)/std::log(2.0)
+                  << ")" << std::endl;
+        for (int k = 0; k < 3; ++k) {
+            std::cout << "   nx0 " << (nx0 << k) << " time " << elapsed[k]
+                      << " s" << std::endl;
+            std::fprintf(fdata, "%d %d %g %g %g\n", orders[o], nx0 << k,
+                elapsed[k], k == 0 ? d01 : (k == 1 ? d12 : 0.0), Q);
+        }
+    }
+    std::fclose(fdata);
+
+    return hpx::finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    try {
+        po::options_description desc_cmdline ("Usage: had_amr_convergence [options]");
+        desc_cmdline.add_options()
+            ("nx0,n", po::value<int>()->default_value(33),
+                "the number of points on the coarsest level of the first run")
+            ("granularity,g", po::value<int>()->default_value(3),
+                "the number of points per block (must divide nx0)")
+            ("allowedl,l", po::value<int>()->default_value(1),
+                "the number of refinement levels")
+            ("numsteps,s", po::value<std::size_t>()->default_value(20),
+                "the number of coarse time steps of the first run")
+            ("prolongation-order,o", po::value<int>(),
+                "the order of the coarse-fine interpolation to test "
+                "(default: 2, 4 and 6)")
+        ;
+
+        return hpx::init(desc_cmdline, argc, argv);
+    }
+    catch (std::exception& e) {
+        std::cerr << "std::exception caught: " << e.what() << "\n";
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "unexpected exception caught\n";
+        return -2;
+    }
+
+    return 0;
+}
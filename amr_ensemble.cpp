@@ -0,0 +1,401 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Ensemble runner for had_amr: computes the evolutions of all combinations
+// of the parameter values given by a sweep specification. The members are
+// independent meshes run as concurrent HPX threads, at most --concurrency of
+// them at a time, so that small meshes which can't keep all cores busy on
+// their own still do so together. The base parameters are read from the
+// had_amr section of a parameter file just like for had_amr_client. The
+// sweep specification holds one line per swept parameter, giving either a
+// list of values or a range start:stop:step, for instance
+//
+//     amp = 0.1 0.2 0.3
+//     R0 = 6:10:1
+//
+// One line is written to ensemble.dat for each member.
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/lcos/local/counting_semaphore.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/program_options.hpp>
+
+#include "amr/unigrid_mesh.hpp"
+#include "amr/cancellation.hpp"
+#include "amr_c/stencil.hpp"
+#include "amr_c/logging.hpp"
+
+namespace po = boost::program_options;
+
+using namespace hpx;
+
+///////////////////////////////////////////////////////////////////////////////
+namespace ensemble
+{
+    typedef components::amr::Parameter Parameter;
+
+    /// A swept parameter and its values
+    struct sweep
+    {
+        std::string key;
+        std::vector<std::string> values;
+    };
+
+    /// The result of the evolution of one member
+    struct member_result
+    {
+        member_result() : outcome(components::amr::evolution_completed),
+            time(0.0), elapsed(0.0) {}
+
+        int outcome;
+        double time;        // time of the detection of the outcome
+        double elapsed;     // wall time of the evolution [s]
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // parse the values of one line of the sweep specification: a list of
+    // values or a range start:stop:step (including stop)
+    bool parse_values(std::string const& text, std::vector<std::string>& values)
+    {
+        std::string::size_type colon = text.find(':');
+        if (colon == std::string::npos) {
+            std::istringstream strm(text);
+            std::string value;
+            while (strm >> value)
+                values.push_back(value);
+            return !values.empty();
+        }
+
+        double start = 0.0, stop = 0.0, step = 0.0;
+        char c1 = 0, c2 = 0;
+        std::istringstream strm(text);
+        if (!(strm >> start >> c1 >> stop >> c2 >> step) || step <= 0.0)
+            return false;
+
+        // allow for rounding errors when reaching stop
+        for (std::size_t i = 0; start + i*step <= stop + 1.e-9*step; ++i) {
+            char buffer[64];
+            sprintf(buffer, "%.17g", start + i*step);
+            values.push_back(buffer);
+        }
+        return !values.empty();
+    }
+
+    bool read_sweeps(std::string const& filename, std::vector<sweep>& sweeps)
+    {
+        std::ifstream in(filename.c_str());
+        if (!in) {
+            std::cerr << " ensemble: unable to read " << filename << std::endl;
+            return false;
+        }
+
+        Parameter scratch;
+        int nx0 = 0;
+
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::string::size_type comment = line.find('#');
+            if (comment != std::string::npos)
+                line.erase(comment);
+
+            std::string::size_type eq = line.find('=');
+            if (eq == std::string::npos) {
+                if (line.find_first_not_of(" \t\r") != std::string::npos) {
+                    std::cerr << " ensemble: malformed line: " << line
+                              << std::endl;
+                    return false;
+                }
+                continue;
+            }
+
+            sweep s;
+            std::istringstream key(line.substr(0, eq));
+            key >> s.key;
+            if (!parse_values(line.substr(eq + 1), s.values)) {
+                std::cerr << " ensemble: no values for " << s.key << std::endl;
+                return false;
+            }
+
+            // reject unknown keys before running anything
+            if (!components::amr::set_parameter(scratch, nx0, s.key, s.values[0])) {
+                std::cerr << " ensemble: unknown parameter " << s.key
+                          << std::endl;
+                return false;
+            }
+            sweeps.push_back(s);
+        }
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The members of the ensemble are the combinations of the swept values,
+    // the first swept parameter varying slowest.
+    class runner
+    {
+    public:
+        runner(Parameter const& par, int nx0, std::vector<sweep> const& sweeps)
+          : par_(par), nx0_(nx0), sweeps_(sweeps), next_(0)
+        {
+            std::size_t count = 1;
+            for (std::size_t i = 0; i < sweeps_.size(); ++i)
+                count *= sweeps_[i].values.size();
+            results_.resize(count);
+        }
+
+        std::size_t size() const
+        {
+            return results_.size();
+        }
+
+        // compute all members, running at most concurrency of them at a time
+        void run(std::size_t concurrency)
+        {
+            std::size_t const workers = (std::min)(concurrency, size());
+
+            lcos::local::counting_semaphore sem(0);
+            for (std::size_t i = 0; i < workers; ++i)
+            {
+                applier::register_thread_nullary(
+                    boost::bind(&runner::worker, this, boost::ref(sem)),
+                    "had_amr_ensemble::worker");
+            }
+            sem.wait(workers);
+        }
+
+        // the value of the given swept parameter for a member
+        std::string const& value(std::size_t member, std::size_t index) const
+        {
+            std::size_t stride = 1;
+            for (std::size_t i = index + 1; i < sweeps_.size(); ++i)
+                stride *= sweeps_[i].values.size();
+            return sweeps_[index].values[(member/stride) %
+                sweeps_[index].values.size()];
+        }
+
+        member_result const& result(std::size_t member) const
+        {
+            return results_[member];
+        }
+
+        // check the parameters of all members before computing any of them
+        bool check() const
+        {
+            bool ok = true;
+            for (std::size_t member = 0; member < size(); ++member)
+            {
+                int nx0 = 0;
+                Parameter par = parameters(member, nx0);
+                if (!components::amr::check_parameters(par, nx0)) {
+                    std::cerr << " ensemble: invalid parameters for member "
+                              << member + 1 << std::endl;
+                    ok = false;
+                }
+            }
+            return ok;
+        }
+
+    private:
+        void worker(lcos::local::counting_semaphore& sem)
+        {
+            for (;;)
+            {
+                std::size_t member = 0;
+                {
+                    mutex_type::scoped_lock l(mtx_);
+                    if (next_ == size())
+                        break;
+                    member = next_++;
+                }
+                results_[member] = compute(member);
+            }
+            sem.signal();
+        }
+
+        // set up the parameters of the given member, which neither logs nor
+        // checkpoints
+        Parameter parameters(std::size_t member, int& nx0) const
+        {
+            // deep copy, the parameters are shared otherwise
+            Parameter par;
+            *par.p = *par_.p;
+            nx0 = nx0_;
+            for (std::size_t i = 0; i < sweeps_.size(); ++i)
+                components::amr::set_parameter(par, nx0, sweeps_[i].key, value(member, i));
+
+            par->evolution_id = member + 1;
+            par->loglevel = 0;
+            par->output_stdout = 0;
+            par->checkpoint = 0;
+            par->restart.clear();
+            return par;
+        }
+
+        // compute the evolution of the given member
+        member_result compute(std::size_t member)
+        {
+            int nx0 = 0;
+            Parameter par = parameters(member, nx0);
+            components::amr::compute_derived_parameters(par, nx0);
+
+            // the dispersal is detected by the logging instance
+            components::component_type logging_type =
+                components::component_invalid;
+            if (par->diagnostics) {
+                logging_type = components::get_component_type<
+                    components::amr::server::logging>();
+
+                FILE *fdata = fopen(components::amr::diagnostics_filename(
+                    *par.p).c_str(),"w");
+                fprintf(fdata,"# time energy max|chi| x(max|chi|)\n");
+                fclose(fdata);
+            }
+
+            naming::id_type here =
+                applier::get_applier().get_runtime_support_gid();
+
+            // nt0 may be one of the swept parameters
+            std::size_t const numsteps = par->nt0;
+
+            member_result result;
+            hpx::util::high_resolution_timer t;
+            {
+                components::amr::unigrid_mesh unigrid_mesh;
+                unigrid_mesh.create(here);
+                components::amr::evolution_status status =
+                    unigrid_mesh.init_execute(
+                        components::get_component_type<components::amr::stencil>(),
+                        par->rowsize[0], numsteps, logging_type, par).status_;
+
+                result.outcome = status.outcome_;
+                std::size_t timestep = status.timestep_;
+                if (status.outcome_ == components::amr::evolution_completed)
+                    timestep = numsteps*level_timestep(*par.p, 0);
+                result.time = double(timestep_to_time(timestep, *par.p));
+            }
+            result.elapsed = t.elapsed();
+            return result;
+        }
+
+        typedef lcos::local::mutex mutex_type;
+
+        Parameter par_;
+        int nx0_;
+        std::vector<sweep> sweeps_;
+        std::vector<member_result> results_;
+
+        mutex_type mtx_;
+        std::size_t next_;          // the next member to compute
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(po::variables_map& vm)
+{
+    std::size_t numsteps = 400;
+    if (vm.count("numsteps"))
+        numsteps = vm["numsteps"].as<std::size_t>();
+
+    components::amr::Parameter par;
+    int nx0;
+    components::amr::set_default_parameters(par, nx0, numsteps);
+
+    if (vm.count("parfile")) {
+        hpx::util::section pars(vm["parfile"].as<std::string>());
+        if (pars.has_section("had_amr")) {
+            components::amr::read_parameters(*pars.get_section("had_amr"),
+                par, nx0);
+        }
+    }
+
+    std::vector<ensemble::sweep> sweeps;
+    if (!ensemble::read_sweeps(vm["sweep"].as<std::string>(), sweeps)) {
+        hpx::finalize();
+        return 1;
+    }
+
+    std::size_t concurrency = hpx::get_os_thread_count();
+    if (vm.count("concurrency"))
+        concurrency = vm["concurrency"].as<std::size_t>();
+    if (concurrency == 0)
+        concurrency = 1;
+
+    ensemble::runner r(par, nx0, sweeps);
+    if (!r.check()) {
+        hpx::finalize();
+        return 1;
+    }
+
+    std::cout << " ensemble: " << r.size() << " members, " << concurrency
+              << " at a time" << std::endl;
+
+    hpx::util::high_resolution_timer t;
+    r.run(concurrency);
+    printf("Elapsed time: %f s\n", t.elapsed());
+
+    FILE *fdata = fopen("ensemble.dat","w");
+    fprintf(fdata,"# member");
+    for (std::size_t i = 0; i < sweeps.size(); ++i)
+        fprintf(fdata," %s",sweeps[i].key.c_str());
+    fprintf(fdata," outcome time elapsed\n");
+
+    for (std::size_t m = 0; m < r.size(); ++m)
+    {
+        ensemble::member_result const& result = r.result(m);
+        fprintf(fdata,"%lu",(unsigned long)(m + 1));
+        for (std::size_t i = 0; i < sweeps.size(); ++i)
+            fprintf(fdata," %s",r.value(m, i).c_str());
+        fprintf(fdata," %s %.17g %f\n",
+            components::amr::get_outcome_name(result.outcome),
+            result.time, result.elapsed);
+    }
+    fclose(fdata);
+
+    return hpx::finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    try {
+        po::options_description desc_cmdline ("Usage: had_amr_ensemble [options]");
+        desc_cmdline.add_options()
+            ("sweep,w", po::value<std::string>()->default_value("sweep.txt"),
+                "the sweep specification: one line 'key = values' for each "
+                "swept parameter, values being a list or a range start:stop:step")
+            ("parfile,p", po::value<std::string>(),
+                "the parameter file holding the base parameters")
+            ("numsteps,s", po::value<std::size_t>(),
+                "the number of time steps to use for each member")
+            ("concurrency,c", po::value<std::size_t>(),
+                "the maximal number of members computed concurrently "
+                "(default: the number of OS threads)")
+        ;
+
+        return hpx::init(desc_cmdline, argc, argv);
+    }
+    catch (std::exception& e) {
+        std::cerr << "std::exception caught: " << e.what() << "\n";
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "unexpected exception caught\n";
+        return -2;
+    }
+
+    return 0;
+}
@@ -0,0 +1,536 @@
+//  Copyright (c) 2007-2012 Hartmut Kaiser
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+// Shared memory engine for had_amr: the evolution is computed over plain
+// arrays of stencil_data, without creating any components. It uses the same
+// data-flow structure (see unigrid_mesh::prep_ports), initial data and
+// update as the component based mesh used by had_amr_client, and produces
+// the same results bit-for-bit. By default the rows of the mesh are computed
+// one after the other, all columns of a row concurrently as HPX threads. In
+// the data-flow mode each update is started as an HPX thread as soon as its
+// inputs are available, no threads are kept waiting for their inputs.
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include <hpx/hpx.hpp>
+#include <hpx/hpx_init.hpp>
+#include <hpx/lcos/local/counting_semaphore.hpp>
+#include <hpx/lcos/local/mutex.hpp>
+#include <hpx/util/high_resolution_timer.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/program_options.hpp>
+
+#include "amr/functional_component.hpp"
+#include "amr/unigrid_mesh.hpp"
+#include "amr_c/stencil.hpp"
+#include "amr_c/stencil_data.hpp"
+#include "amr_c_test/stencil_functions.hpp"
+
+namespace po = boost::program_options;
+
+using namespace hpx;
+
+///////////////////////////////////////////////////////////////////////////////
+namespace local
+{
+    typedef components::amr::Parameter Parameter;
+    typedef components::amr::server::unigrid_mesh mesh_type;
+
+    ///////////////////////////////////////////////////////////////////////////
+    // The evolution on a single locality. Each stencil (row, column) of the
+    // mesh owns par->pipeline_depth blocks holding its last outputs, just like
+    // dynamic_stencil_value. The n-th update of a stencil consumes the n-th
+    // output of each of its inputs; the first row starts off with the
+    // initial data as its first output.
+    class engine
+    {
+    public:
+        engine(Parameter const& par, std::size_t numsteps)
+          : par_(par), numsteps_(numsteps), depth_(par->pipeline_depth),
+            outstanding_(0), finished_(false), done_(0)
+        {
+            mesh_type::row_layout(par_, each_row_, level_row_);
+            num_rows_ = each_row_.size();
+
+            std::size_t memsize = 6;
+            Array3D dst_port(num_rows_,each_row_[0],memsize);
+            Array3D dst_src(num_rows_,each_row_[0],memsize);
+            Array3D dst_step(num_rows_,each_row_[0],memsize);
+            Array3D dst_size(num_rows_,each_row_[0],1);
+            Array3D src_size(num_rows_,each_row_[0],1);
+            mesh_type::prep_ports(dst_port,dst_src,dst_step,dst_size,src_size,
+                num_rows_,each_row_,level_row_,par_);
+
+            // the inputs of each stencil in the order of its input ports, and
+            // the stencils consuming its outputs
+            inputs_.resize(num_rows_);
+            kinds_.resize(num_rows_);
+            consumers_.resize(num_rows_);
+            values_.resize(num_rows_);
+            published_.resize(num_rows_);
+            evals_.resize(num_rows_);
+            active_.resize(num_rows_);
+            scheduled_.resize(num_rows_);
+            for (std::size_t row = 0; row < num_rows_; ++row)
+            {
+                inputs_[row].resize(each_row_[row]);
+                kinds_[row].resize(each_row_[row]);
+                consumers_[row].resize(each_row_[row]);
+                values_[row].resize(depth_*each_row_[row]);
+                published_[row].resize(each_row_[row], row == 0 ? 1 : 0);
+                evals_[row].resize(each_row_[row], 0);
+                active_[row].resize(each_row_[row], 1);
+                scheduled_[row].resize(each_row_[row], 0);
+            }
+            for (std::size_t row = 0; row < num_rows_; ++row)
+            {
+                for (std::size_t column = 0; column < each_row_[row]; ++column)
+                {
+                    for (int j = 0; j < dst_size(row, column, 0); ++j) {
+                        input src(dst_step(row, column, j), dst_src(row, column, j));
+                        inputs_[row][column].push_back(src);
+                        consumers_[src.first][src.second].push_back(
+                            input(row, column));
+                    }
+                    kinds_[row][column] = get_stencil_kind(*par_.p, column,
+                        inputs_[row][column].size());
+                }
+            }
+            active_first_row_ = each_row_[0];
+
+            // forget about an earlier cancellation of this evolution
+            components::amr::reset_evolution(par_->evolution_id);
+
+            // the blocks of each column are first touched by the worker
+            // thread its updates are run on
+            lcos::local::counting_semaphore sem(0);
+            for (std::size_t column = 0; column < each_row_[0]; ++column)
+            {
+                applier::register_thread_nullary(
+                    boost::bind(&engine::first_touch_column, this, column,
+                        boost::ref(sem)),
+                    "had_amr_local::first_touch_column", threads::pending, true,
+                    threads::thread_priority_normal, os_thread(column));
+            }
+            sem.wait(each_row_[0]);
+
+            for (std::size_t column = 0; column < each_row_[0]; ++column)
+            {
+                generate_initial_data(&output(0, column, 0), column,
+                    each_row_[0], 0, *par_.p);
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // compute the evolution row by row: rows 1..num_rows-1 consume the
+        // values published by the preceding rows in the same cycle, row 0
+        // consumes the values of the last rows, closing the cycle
+        void run_rows()
+        {
+            while (active_first_row_ != 0) {
+                for (std::size_t row = 1; row < num_rows_; ++row)
+                    compute_row(row);
+                compute_row(0);
+            }
+        }
+
+        // compute the evolution as a data-flow graph: every update is
+        // started as soon as its inputs have been published and all
+        // consumers have read the output previously stored in the block it
+        // writes to, there is no synchronization between the rows
+        void run_dataflow()
+        {
+            {
+                mutex_type::scoped_lock l(mtx_);
+                for (std::size_t row = 0; row < num_rows_; ++row) {
+                    for (std::size_t column = 0; column < each_row_[row]; ++column)
+                        schedule_if_ready(row, column);
+                }
+                if (outstanding_ == 0)
+                    return;
+            }
+            done_.wait();
+        }
+
+        // the number of cycles through all rows of the mesh
+        std::size_t cycles() const
+        {
+            return *std::max_element(evals_[0].begin(), evals_[0].end());
+        }
+
+        // the final values of all columns
+        std::vector<stencil_data const*> result()
+        {
+            std::vector<stencil_data const*> result;
+            for (std::size_t column = 0; column < each_row_[0]; ++column)
+                result.push_back(&output(0, column, published_[0][column]-1));
+            return result;
+        }
+
+    private:
+        typedef lcos::local::mutex mutex_type;
+        typedef std::pair<std::size_t, std::size_t> input;   // (row, column)
+
+        stencil_data& output(std::size_t row, std::size_t column, std::size_t n)
+        {
+            return values_[row][depth_*column + n % depth_];
+        }
+
+        // fine stencils next to an interface are on the critical path
+        threads::thread_priority priority(std::size_t column) const
+        {
+            if (par_->thread_scheduler == 1 && is_critical_column(*par_.p, column))
+                return threads::thread_priority_critical;
+            return threads::thread_priority_normal;
+        }
+
+        // the worker thread the given column is pinned to (if any)
+        std::size_t os_thread(std::size_t column) const
+        {
+            return numa_os_thread(*par_.p, column, hpx::get_os_thread_count());
+        }
+
+        void first_touch_column(std::size_t column,
+            lcos::local::counting_semaphore& sem)
+        {
+            for (std::size_t row = 0; row < num_rows_; ++row) {
+                if (column >= each_row_[row])
+                    continue;
+                for (std::size_t k = 0; k < depth_; ++k) {
+                    components::amr::first_touch(
+                        values_[row][depth_*column + k], column, *par_.p);
+                }
+            }
+            sem.signal();
+        }
+
+        // compute the next update of the given stencil
+        void compute(std::size_t row, std::size_t column)
+        {
+            std::vector<input> const& in = inputs_[row][column];
+            std::size_t const n = evals_[row][column];
+
+            // inputs which have reached their last time step already provide
+            // their last output
+            std::vector<stencil_data*> val(in.size());
+            {
+                mutex_type::scoped_lock l(mtx_);
+                for (std::size_t i = 0; i < in.size(); ++i) {
+                    std::size_t k = (std::min)(n,
+                        published_[in[i].first][in[i].second]-1);
+                    val[i] = &output(in[i].first, in[i].second, k);
+                }
+            }
+            std::vector<std::size_t> offset(in.size(), 0);
+
+            std::size_t const w = (row == 0) ? n + 1 : n;
+            bool updated = false;
+            std::size_t timesteps_to_go = components::amr::eval_kernel(
+                output(row, column, w), val, offset, column,
+                kinds_[row][column], numsteps_, *par_.p, updated);
+
+            // publish the new value
+            mutex_type::scoped_lock l(mtx_);
+            published_[row][column] = w + 1;
+            evals_[row][column] = n + 1;
+            if (timesteps_to_go == 0) {
+                active_[row][column] = 0;
+                if (row == 0)
+                    --active_first_row_;
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // compute all active columns of the given row concurrently
+        void compute_row(std::size_t row)
+        {
+            lcos::local::counting_semaphore sem(0);
+
+            std::size_t count = 0;
+            for (std::size_t column = 0; column < each_row_[row]; ++column)
+            {
+                if (!active_[row][column])
+                    continue;
+
+                applier::register_thread_nullary(
+                    boost::bind(&engine::row_update, this, row, column,
+                        boost::ref(sem)),
+                    "had_amr_local::row_update", threads::pending, true,
+                    priority(column), os_thread(column));
+                ++count;
+            }
+            sem.wait(count);
+        }
+
+        void row_update(std::size_t row, std::size_t column,
+            lcos::local::counting_semaphore& sem)
+        {
+            compute(row, column);
+            sem.signal();
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // must be called with mtx_ being locked
+        bool is_ready(std::size_t row, std::size_t column) const
+        {
+            if (finished_ || !active_[row][column] || scheduled_[row][column])
+                return false;
+
+            std::size_t const n = evals_[row][column];
+            std::vector<input> const& in = inputs_[row][column];
+            for (std::size_t i = 0; i < in.size(); ++i) {
+                std::size_t r = in[i].first, c = in[i].second;
+                if (active_[r][c] && published_[r][c] <= n)
+                    return false;
+            }
+
+            // the block written by the update holds the output published
+            // pipeline_depth steps before
+            std::size_t const w = (row == 0) ? n + 1 : n;
+            if (w >= depth_) {
+                std::vector<input> const& out = consumers_[row][column];
+                for (std::size_t i = 0; i < out.size(); ++i) {
+                    std::size_t r = out[i].first, c = out[i].second;
+                    if (active_[r][c] && evals_[r][c] <= w-depth_)
+                        return false;
+                }
+            }
+            return true;
+        }
+
+        void schedule_if_ready(std::size_t row, std::size_t column)
+        {
+            if (!is_ready(row, column))
+                return;
+
+            scheduled_[row][column] = 1;
+            ++outstanding_;
+            applier::register_thread_nullary(
+                boost::bind(&engine::dataflow_update, this, row, column),
+                "had_amr_local::dataflow_update", threads::pending, true,
+                priority(column), os_thread(column));
+        }
+
+        void dataflow_update(std::size_t row, std::size_t column)
+        {
+            compute(row, column);
+
+            mutex_type::scoped_lock l(mtx_);
+            scheduled_[row][column] = 0;
+            --outstanding_;
+
+            // the evolution is finished as soon as the first row is done,
+            // the remaining updates are drained
+            if (active_first_row_ == 0)
+                finished_ = true;
+
+            // the new output may complete the inputs of the consumers, the
+            // read inputs may free the blocks of the producers
+            schedule_if_ready(row, column);
+            std::vector<input> const& out = consumers_[row][column];
+            for (std::size_t i = 0; i < out.size(); ++i)
+                schedule_if_ready(out[i].first, out[i].second);
+            std::vector<input> const& in = inputs_[row][column];
+            for (std::size_t i = 0; i < in.size(); ++i)
+                schedule_if_ready(in[i].first, in[i].second);
+
+            if (outstanding_ == 0)
+                done_.signal();
+        }
+
+        Parameter par_;
+        std::size_t numsteps_;
+        std::size_t depth_;
+        std::size_t num_rows_;
+        std::vector<std::size_t> each_row_, level_row_;
+        std::vector<std::vector<std::vector<input> > > inputs_;
+        std::vector<std::vector<stencil_kind> > kinds_;
+        std::vector<std::vector<std::vector<input> > > consumers_;
+        std::vector<std::vector<stencil_data> > values_;
+
+        // the state of each stencil, protected by mtx_
+        mutex_type mtx_;
+        std::vector<std::vector<std::size_t> > published_;   // outputs published
+        std::vector<std::vector<std::size_t> > evals_;       // updates computed
+        std::vector<std::vector<int> > active_;
+        std::vector<std::vector<int> > scheduled_;
+        std::size_t active_first_row_;
+        std::size_t outstanding_;
+        bool finished_;
+        lcos::local::counting_semaphore done_;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // set up a parameter set using the defaults of had_amr_client, returns
+    // false if the parameters are rejected
+    bool make_parameters(Parameter& par, int granularity, int allowedl,
+        int nx0, std::size_t numsteps, int order, int depth, int domains)
+    {
+        int default_nx0;
+        components::amr::set_default_parameters(par, default_nx0, numsteps);
+        par->allowedl    = allowedl;
+        par->loglevel    = 0;
+        par->granularity = granularity;
+        par->prolongation_order = order;
+        par->pipeline_depth = depth;
+        par->numa_domains = domains;
+
+        if (!components::amr::check_parameters(par, nx0))
+            return false;
+
+        components::amr::compute_derived_parameters(par, nx0);
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // run the same evolution using the component based mesh, return the
+    // number of blocks differing from the given result
+    std::size_t verify(Parameter const& par, std::size_t numsteps,
+        std::vector<stencil_data const*> const& result)
+    {
+        components::component_type function_type =
+            components::get_component_type<components::amr::stencil>();
+
+        naming::id_type here = applier::get_applier().get_runtime_support_gid();
+
+        std::vector<naming::id_type> result_data;
+        {
+            components::amr::unigrid_mesh unigrid_mesh;
+            unigrid_mesh.create(here);
+            result_data = unigrid_mesh.init_execute(function_type,
+                par->rowsize[0], numsteps, components::component_invalid,
+                par).result_data_;
+        }
+
+        std::size_t mismatches = 0;
+        for (std::size_t i = 0; i < result_data.size(); ++i)
+        {
+            components::access_memory_block<stencil_data> val(
+                components::stubs::memory_block::get(result_data[i]));
+
+            stencil_data const& lhs = *result[i];
+            stencil_data const& rhs = val.get();
+            bool equal = lhs.timestep_ == rhs.timestep_ &&
+                lhs.level_ == rhs.level_ &&
+                lhs.value_.size() == rhs.value_.size();
+            for (std::size_t j = 0; equal && j < lhs.value_.size(); ++j) {
+                for (int k = 0; k < num_eqns; ++k) {
+                    if (lhs.value_[j].phi[0][k] != rhs.value_[j].phi[0][k])
+                        equal = false;
+                }
+            }
+            if (!equal)
+                ++mismatches;
+        }
+        return mismatches;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int hpx_main(po::variables_map& vm)
+{
+    int nx0 = vm["nx0"].as<int>();
+    int granularity = vm["granularity"].as<int>();
+    int allowedl = vm["allowedl"].as<int>();
+    std::size_t numsteps = vm["numsteps"].as<std::size_t>();
+    int order = vm["prolongation-order"].as<int>();
+    int depth = vm["pipeline-depth"].as<int>();
+    int domains = vm["numa-domains"].as<int>();
+
+    local::Parameter par;
+    if (!local::make_parameters(par, granularity, allowedl, nx0, numsteps,
+            order, depth, domains))
+    {
+        hpx::finalize();
+        return 1;
+    }
+
+    std::vector<stencil_data const*> result;
+    {
+        hpx::util::high_resolution_timer t;
+        local::engine e(par, numsteps);
+        if (vm.count("dataflow"))
+            e.run_dataflow();
+        else
+            e.run_rows();
+        printf("Elapsed time: %f s (%lu cycles)\n", t.elapsed(),
+            (unsigned long)e.cycles());
+
+        components::amr::evolution_status status =
+            components::amr::get_evolution_status(par->evolution_id);
+        printf("Outcome: %s\n", components::amr::get_outcome_name(status.outcome_));
+
+        // the blocks are owned by the engine, check them before it goes
+        // out of scope
+        result = e.result();
+
+        double checksum = 0.0;
+        for (std::size_t i = 0; i < result.size(); ++i) {
+            for (std::size_t j = 0; j < result[i]->value_.size(); ++j)
+                checksum += double(result[i]->value_[j].phi[0][0]);
+        }
+        printf("Checksum: %.17g\n", checksum);
+
+        if (vm.count("verify")) {
+            std::size_t mismatches = local::verify(par, numsteps, result);
+            if (mismatches) {
+                std::cerr << "Verification failed: " << mismatches
+                          << " blocks differ from the component based mesh"
+                          << std::endl;
+            }
+            else {
+                std::cout << "Verification passed" << std::endl;
+            }
+        }
+    }
+
+    return hpx::finalize();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char* argv[])
+{
+    try {
+        po::options_description desc_cmdline ("Usage: had_amr_local [options]");
+        desc_cmdline.add_options()
+            ("nx0,n", po::value<int>()->default_value(33),
+                "the number of points on the coarsest level")
+            ("granularity,g", po::value<int>()->default_value(3),
+                "the number of points per block (must divide nx0)")
+            ("allowedl,l", po::value<int>()->default_value(0),
+                "the number of refinement levels")
+            ("numsteps,s", po::value<std::size_t>()->default_value(400),
+                "the number of coarse time steps")
+            ("prolongation-order,o", po::value<int>()->default_value(2),
+                "the order of the coarse-fine interpolation (2, 4 or 6)")
+            ("pipeline-depth,w", po::value<int>()->default_value(2),
+                "the number of outputs kept by each stencil, allowing it to "
+                "run ahead of its consumers by pipeline-depth-1 steps")
+            ("numa-domains", po::value<int>()->default_value(1),
+                "the number of NUMA domains the columns are spread over "
+                "(1: no affinity)")
+            ("dataflow", "start each update as soon as its inputs are "
+                "available instead of computing the mesh row by row")
+            ("verify", "run the same evolution using the component based "
+                "mesh and compare the results")
+        ;
+
+        return hpx::init(desc_cmdline, argc, argv);
+    }
+    catch (std::exception& e) {
+        std::cerr << "std::exception caught: " << e.what() << "\n";
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "unexpected exception caught\n";
+        return -2;
+    }
+
+    return 0;
+}
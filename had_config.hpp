@@ -21,6 +21,28 @@ typedef mpfr::mpreal had_double_type;
 #else
 typedef double had_double_type;
 #endif
+
+#if defined(__cplusplus)
+#include <string>
+#include <boost/lexical_cast.hpp>
+
+// name of the floating point type used for had_double_type (including the
+// currently active precision for mpreal)
+inline std::string had_precision_name()
+{
+#ifdef MPFR_FOUND
+#   ifdef HAD_AMR_USE_MPET
+    return "mpet";
+#   else
+    return "mpfr" + boost::lexical_cast<std::string>(
+        mpfr::mpreal::get_default_prec());
+#   endif
+#else
+    return "double";
+#endif
+}
+#endif
+
 const int num_eqns = 3;
 const int maxlevels = 20;
 
@@ -7,7 +7,10 @@
 #define HPX_COMPONENTS_PARAMETER_OCT_23_2009_1249PM
 
 #include "had_config.hpp"
+#include <boost/assert.hpp>
 #include <boost/serialization/vector.hpp>
+#include <algorithm>
+#include <string>
 
 class Array3D {
     size_t m_width, m_height;
@@ -40,6 +43,7 @@ struct Par {
       int allowedl;
       int loglevel;
       had_double_type output;
+      std::size_t output_every;   // output cadence in finest level steps
       int output_stdout;
       int nx0;
       int nt0;
@@ -57,12 +61,147 @@ struct Par {
       int output_level;
       int PP;
       int granularity;
+      int granularity_level[maxlevels];   // points per block on each level
+      int checkpoint;                 // checkpoint cadence in coarse steps (0: none)
+      std::size_t checkpoint_every;   // checkpoint cadence in finest level steps
+      std::string restart;            // checkpoint file to restart from
+      int placement;                  // 0: distributing factory, 1: contiguous columns,
+                                      // 2: contiguous columns weighted by cost
+      int prolongation_order;         // order of the coarse-fine interpolation (2, 4, 6)
+      int pipeline_depth;             // number of values kept by each stencil (>= 2)
+      int dataflow;                   // 1: the updates of each stencil run as
+                                      // continuations of its inputs, no driver thread
+      int thread_scheduler;           // 0: equal priorities, 1: critical priority
+                                      // for fine stencils next to an interface
+      int numa_domains;               // NUMA domains of each locality (1: no affinity)
+      int diagnostics;                // 1: reduce global diagnostics at the output times
+      had_double_type dispersal_threshold;  // max|chi| below which the field has
+                                      // dispersed (0: no dispersal detection)
+      std::size_t evolution_id;       // identifies concurrent evolutions
       std::vector<std::size_t> rowsize;
       std::vector<std::size_t> level_begin, level_end;
+      std::vector<std::size_t> each_row;  // number of points of each row of the mesh
+      std::vector<std::size_t> level_row; // finest level of each row of the mesh
+      std::vector<had_double_type> level_startx;  // coordinate of the first point
+                                      // of each level
+      std::vector<std::size_t> locality_bounds;   // first column placed on each
+                                      // locality and rowsize[0] (set by the mesh)
 };
 
 #if defined(__cplusplus)
 }
+
+// number of finest level steps covered by one step on the given level
+inline std::size_t level_timestep(Par const& par, int level)
+{
+    return std::size_t(1) << (par.allowedl - level);
+}
+
+// convert a timestep counter (in finest level steps) to physical time
+inline had_double_type timestep_to_time(std::size_t timestep, Par const& par)
+{
+    had_double_type t(double(timestep) / double(level_timestep(par, 0)));
+    return t * par.dt0;
+}
+
+// refinement level the given column belongs to
+inline int level_of_column(Par const& par, std::size_t column)
+{
+    for (int j=0;j<=par.allowedl;j++) {
+      if (column >= par.level_begin[j] && column < par.level_end[j]) return j;
+    }
+    return -1;
+}
+
+// whether the given column belongs to the blocks of a refined level next to
+// its interface with the coarser level: these gate the progress of the
+// coarser level, which needs the interpolated values after every second
+// step of the finer level
+inline bool is_critical_column(Par const& par, std::size_t column)
+{
+    int level = level_of_column(par, column);
+    if (level <= 0) return false;
+    return par.level_end[level]-1 - column < 2;
+}
+
+// the kinds of stencils, depending on the position of the column in the mesh
+// and on the number of inputs it has in its row; the kind of each stencil is
+// fixed, it is determined once when the mesh is wired
+enum stencil_kind
+{
+    stencil_interior = 0,         // three inputs on the same level
+    stencil_left_boundary = 1,    // two inputs, first column of a level
+    stencil_right_boundary = 2,   // two inputs, last column of a level
+    stencil_case_one = 3,         // three inputs, the left one is finer
+    stencil_case_two = 4          // three inputs, the right one is coarser
+};
+
+inline stencil_kind get_stencil_kind(Par const& par, std::size_t column,
+    std::size_t numinputs)
+{
+    int level = level_of_column(par, column);
+    BOOST_ASSERT(level >= 0);
+
+    if ( numinputs%2 == 0 ) {
+      if ( column == par.level_end[level]-1 ) return stencil_right_boundary;
+      BOOST_ASSERT(column == par.level_begin[level]);
+      return stencil_left_boundary;
+    }
+    if ( level_of_column(par, column-1) == level+1 ) return stencil_case_one;
+    if ( level > 0 && level_of_column(par, column+1) == level-1 ) return stencil_case_two;
+    return stencil_interior;
+}
+
+// the worker thread the stencils of the given column are pinned to: the
+// columns placed on the locality of the given column are split into
+// contiguous ranges, one for each NUMA domain, and spread over the worker
+// threads of their domain (the worker threads are assumed to be numbered
+// domain by domain), -1 if there is no affinity
+inline std::size_t numa_os_thread(Par const& par, std::size_t column,
+    std::size_t num_os_threads)
+{
+    if (par.numa_domains <= 1 || num_os_threads < std::size_t(par.numa_domains))
+        return std::size_t(-1);
+
+    // all columns are on this locality unless the mesh has placed them
+    std::size_t first = 0;
+    std::size_t last = par.rowsize[0];
+    if (!par.locality_bounds.empty()) {
+        std::vector<std::size_t>::const_iterator it = std::upper_bound(
+            par.locality_bounds.begin(), par.locality_bounds.end(), column);
+        BOOST_ASSERT(it != par.locality_bounds.begin() &&
+                     it != par.locality_bounds.end());
+        first = *(it-1);
+        last = *it;
+    }
+
+    std::size_t const domains = par.numa_domains;
+    std::size_t const domain = (column-first)*domains/(last-first);
+    std::size_t const per_domain = num_os_threads/domains;
+    return domain*per_domain + (column-first)%per_domain;
+}
+
+// grid spacing on the given level
+inline had_double_type level_dx(Par const& par, int level)
+{
+    return par.dx0/double(std::size_t(1) << level);
+}
+
+// coordinate of the first point of the block in the given column; the finer
+// levels cover the region next to the origin
+inline had_double_type block_startx(Par const& par, int level, std::size_t column)
+{
+    std::size_t const points = (column-par.level_begin[level])*par.granularity_level[level];
+    return par.level_startx[level] + double(points)*level_dx(par, level);
+}
+
+// coordinate of the point at the given offset in the block in the given
+// column (the offset may reach past the end of the block)
+inline had_double_type point_x(Par const& par, int level, std::size_t column,
+    std::size_t offset)
+{
+    return block_startx(par, level, column) + int(offset)*level_dx(par, level);
+}
 #endif
 
 #endif
@@ -6,9 +6,13 @@
 #if !defined(HPX_COMPONENTS_PARAMETER_OCT_19_2009_0834AM)
 #define HPX_COMPONENTS_PARAMETER_OCT_19_2009_0834AM
 
+#include <hpx/hpx_fwd.hpp>
+
 #include <boost/cstdint.hpp>
 #include <boost/serialization/serialization.hpp>
 
+#include <string>
+
 #include "parameter.h"
 
 #include <hpx/config/warnings_prefix.hpp>
@@ -44,6 +48,37 @@ namespace hpx { namespace components { namespace amr
         void serialize(Archive &ar, const unsigned int version);
     };
 
+    /// Compute all parameters derived from the number of coarse mesh points
+    /// \a nx0: the layout of the refinement hierarchy (nx, rowsize,
+    /// level_begin, level_end, each_row, level_row, level_startx), the grid
+    /// spacing and the output cadence. The parameters have to have passed
+    /// check_parameters.
+    HPX_COMPONENT_EXPORT void compute_derived_parameters(Parameter& par,
+        int nx0);
+
+    /// Set all parameters to the defaults of had_amr_client, \a nx0 is set
+    /// to the default number of coarse mesh points.
+    HPX_COMPONENT_EXPORT void set_default_parameters(Parameter& par,
+        int& nx0, std::size_t numsteps);
+
+    /// Set the parameter with the given name (as used in the had_amr section
+    /// of a parameter file) from its textual value. Returns false if there
+    /// is no such parameter.
+    HPX_COMPONENT_EXPORT bool set_parameter(Parameter& par, int& nx0,
+        std::string const& key, std::string const& value);
+
+    /// Read all parameters given in the had_amr section \a sec of a
+    /// parameter file, the keys not naming a parameter are left alone.
+    HPX_COMPONENT_EXPORT void read_parameters(util::section& sec,
+        Parameter& par, int& nx0);
+
+    /// Check the parameters against the ranges given by the parameter schema
+    /// (see parameter_schema.h) and the constraints between them (for
+    /// instance nx0 has to be divisible by the granularity). All problems
+    /// are reported, returns false if there was any. This is meant to be
+    /// called before compute_derived_parameters.
+    HPX_COMPONENT_EXPORT bool check_parameters(Parameter const& par, int nx0);
+
 ///////////////////////////////////////////////////////////////////////////////
 }}}
 
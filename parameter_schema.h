@@ -0,0 +1,79 @@
+//  Copyright (c) 2009 Matt Anderson
+//
+//  Distributed under the Boost Software License, Version 1.0. (See accompanying
+//  file LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#if !defined(HPX_COMPONENTS_PARAMETER_SCHEMA_OCT_18_2012_1130PM)
+#define HPX_COMPONENTS_PARAMETER_SCHEMA_OCT_18_2012_1130PM
+
+#include <climits>
+
+// The parameters read from the had_amr section of a parameter file. Each
+// entry gives the name of the key (which is the name of the member of Par),
+// its kind (int, real or string), the default value, the smallest and the
+// largest valid value (ignored for strings) and a description. The macro
+// P is applied to all entries in this order, allowedl comes first as it
+// bounds the per level keys. This header does not depend on HPX.
+#define HAD_AMR_PARAMETERS(P)                                                 \
+    P(allowedl, int, 0, 0, maxlevels-1,                                       \
+        "number of refinement levels")                                        \
+    P(lambda, real, 0.15, 0.0, 1.0,                                           \
+        "Courant factor dt/dx")                                               \
+    P(loglevel, int, 2, 0, 2,                                                 \
+        "amount of output written by the logging instance (0: none)")        \
+    P(output, real, 1.0, 0.0, 1.e30,                                          \
+        "output cadence in coarse steps")                                     \
+    P(output_stdout, int, 0, 0, 1,                                            \
+        "echo the output to stdout")                                          \
+    P(output_level, int, 0, 0, maxlevels-1,                                   \
+        "coarsest level written to the output files")                         \
+    P(nt0, int, 400, 0, INT_MAX,                                              \
+        "number of coarse time steps")                                        \
+    P(thread_scheduler, int, 1, 0, 1,                                         \
+        "1: fine stencils next to an interface run at critical priority")     \
+    P(numa_domains, int, 1, 1, INT_MAX,                                       \
+        "NUMA domains of each locality (1: no affinity)")                     \
+    P(diagnostics, int, 0, 0, 1,                                              \
+        "reduce the global diagnostics at the output times")                  \
+    P(dispersal_threshold, real, 0.0, 0.0, 1.e30,                             \
+        "max|chi| below which the field has dispersed (0: no detection)")    \
+    P(maxx0, real, 15.0, 0.0, 1.e30,                                          \
+        "outer boundary of the radial domain")                                \
+    P(ethreshold, real, 0.005, 0.0, 1.e30,                                    \
+        "error threshold")                                                    \
+    P(R0, real, 8.0, -1.e30, 1.e30,                                           \
+        "center of the initial pulse")                                        \
+    P(delta, real, 1.0, 0.0, 1.e30,                                           \
+        "width of the initial pulse")                                         \
+    P(amp, real, 0.1, -1.e30, 1.e30,                                          \
+        "amplitude of the initial pulse")                                     \
+    P(PP, int, 7, 1, INT_MAX,                                                 \
+        "power of the nonlinear term")                                        \
+    P(eps, real, 0.0, 0.0, 1.e30,                                             \
+        "amount of dissipation")                                              \
+    P(checkpoint, int, 0, 0, INT_MAX,                                         \
+        "checkpoint cadence in coarse steps, a multiple of 2 (0: none)")      \
+    P(placement, int, 2, 0, 2,                                                \
+        "0: distributing factory, 1: contiguous columns, 2: weighted by cost")\
+    P(prolongation_order, int, 2, 2, 6,                                       \
+        "order of the coarse-fine interpolation (2, 4 or 6)")                 \
+    P(pipeline_depth, int, 2, 2, INT_MAX,                                     \
+        "number of values kept by each stencil")                              \
+    P(dataflow, int, 0, 0, 1,                                                 \
+        "1: run the updates as continuations of their inputs")                \
+    P(restart, string, "", 0, 0,                                              \
+        "checkpoint file to restart from")                                    \
+    P(granularity, int, 3, 1, INT_MAX,                                        \
+        "number of points per block")                                         \
+    /**/
+
+// The parameters given for each refinement level N by the keys <name>_N,
+// with the same entries as above.
+#define HAD_AMR_LEVEL_PARAMETERS(P)                                           \
+    P(refine_level, real, 1.5, 0.0, 2.0,                                      \
+        "extent of the next finer level relative to this level (0 < r < 2)")  \
+    P(granularity_level, int, 0, 0, INT_MAX,                                  \
+        "number of points per block on this level (0: granularity)")          \
+    /**/
+
+#endif